@@ -0,0 +1,251 @@
+#include "wave/activity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "wave/byte_order.h"
+#include "wave/codec.h"
+#include "wave/file.h"
+#include "wave/io/file_copy.h"
+
+namespace wave {
+
+namespace {
+
+// frames decoded at once by ComputeActivityMap, when blocks are smaller
+const uint64_t kReadFrameNumber = 16384;
+
+// sidecar header: ID, version, block and file frame numbers, block number.
+// Values are little-endian.
+const char kActivityMapId[] = "wact";
+const uint32_t kActivityMapVersion = 1;
+const uint64_t kActivityMapHeaderSize = 32;
+
+template <typename T>
+bool WriteValue(FILE* file, T value) {
+  value = internal::ToFileOrder(value, false);
+  return fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+bool ReadValue(FILE* file, T* value) {
+  if (fread(value, sizeof(T), 1, file) != 1) {
+    return false;
+  }
+  *value = internal::FromFileOrder(*value, false);
+  return true;
+}
+
+// without overflow when block_frame_number is large
+uint64_t BlockNumber(uint64_t frame_number, uint64_t block_frame_number) {
+  return frame_number / block_frame_number +
+         (frame_number % block_frame_number != 0);
+}
+
+}  // namespace
+
+Error ComputeActivityMap(const std::string& path, uint64_t block_frame_number,
+                         ActivityMap* output) {
+  if (block_frame_number == 0) {
+    return kInvalidFormat;
+  }
+  File file;
+  auto error = file.Open(path, kIn);
+  if (error != kNoError) {
+    return error;
+  }
+  auto channel_number = file.channel_number();
+  auto frame_number = file.frame_number();
+  output->block_frame_number = block_frame_number;
+  output->frame_number = frame_number;
+  output->levels.assign(BlockNumber(frame_number, block_frame_number), 0.f);
+
+  // several small blocks are decoded at once
+  auto read_frame_number =
+      std::max(block_frame_number,
+               kReadFrameNumber - kReadFrameNumber % block_frame_number);
+  std::vector<float> samples(read_frame_number * channel_number);
+  size_t block = 0;
+  for (uint64_t frame = 0; frame < frame_number;
+       frame += read_frame_number) {
+    auto count = std::min(read_frame_number, frame_number - frame);
+    error = file.Read(count, samples.data());
+    if (error != kNoError) {
+      return error;
+    }
+    for (uint64_t block_frame = 0; block_frame < count;
+         block_frame += block_frame_number, block++) {
+      auto block_sample_number =
+          std::min(block_frame_number, count - block_frame) * channel_number;
+      auto sum = internal::SumOfSquares(
+          samples.data() + block_frame * channel_number, block_sample_number);
+      output->levels[block] = std::sqrt(sum / block_sample_number);
+    }
+  }
+  return kNoError;
+}
+
+Error WriteActivityMap(const std::string& path, const ActivityMap& map) {
+  auto file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return kFailedToOpen;
+  }
+  auto written = fwrite(kActivityMapId, 4, 1, file) == 1 &&
+                 WriteValue(file, kActivityMapVersion) &&
+                 WriteValue(file, map.block_frame_number) &&
+                 WriteValue(file, map.frame_number) &&
+                 WriteValue(file, static_cast<uint64_t>(map.levels.size()));
+  for (auto level : map.levels) {
+    uint32_t bits;
+    memcpy(&bits, &level, sizeof(bits));
+    written = written && WriteValue(file, bits);
+  }
+  written = fclose(file) == 0 && written;
+  return written ? kNoError : kWriteError;
+}
+
+Error ReadActivityMap(const std::string& path, ActivityMap* output) {
+  auto file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return kFailedToOpen;
+  }
+  char id[4];
+  uint32_t version = 0;
+  uint64_t level_number = 0;
+  auto error = kNoError;
+  if (fread(id, 4, 1, file) != 1 || memcmp(id, kActivityMapId, 4) != 0 ||
+      !ReadValue(file, &version) || version != kActivityMapVersion ||
+      !ReadValue(file, &output->block_frame_number) ||
+      !ReadValue(file, &output->frame_number) ||
+      !ReadValue(file, &level_number) || output->block_frame_number == 0 ||
+      level_number != BlockNumber(output->frame_number,
+                                  output->block_frame_number) ||
+      // levels are only allocated once the file is known to hold them
+      level_number > (FileSize(file) - kActivityMapHeaderSize) /
+                         sizeof(uint32_t)) {
+    error = kInvalidFormat;
+  }
+  if (error == kNoError) {
+    output->levels.resize(level_number);
+    for (auto& level : output->levels) {
+      uint32_t bits;
+      if (!ReadValue(file, &bits)) {
+        error = kReadError;
+        break;
+      }
+      memcpy(&level, &bits, sizeof(bits));
+    }
+  }
+  fclose(file);
+  return error;
+}
+
+std::vector<Span> ActiveSpans(const ActivityMap& map, float threshold) {
+  std::vector<Span> spans;
+  for (size_t block = 0; block < map.levels.size(); block++) {
+    if (map.levels[block] < threshold) {
+      continue;
+    }
+    auto frame_index = block * map.block_frame_number;
+    auto frame_number =
+        std::min(map.block_frame_number, map.frame_number - frame_index);
+    if (!spans.empty() &&
+        spans.back().frame_index + spans.back().frame_number == frame_index) {
+      spans.back().frame_number += frame_number;
+    } else {
+      spans.push_back({frame_index, frame_number});
+    }
+  }
+  return spans;
+}
+
+class ActivityReader::Impl {
+ public:
+  Impl() : span_index(0), span_offset(0), position(0), active_frame_number(0) {}
+
+  File file;
+  std::vector<Span> spans;
+  // span being read and the frames of it already read
+  size_t span_index;
+  uint64_t span_offset;
+  // active frames read
+  uint64_t position;
+  uint64_t active_frame_number;
+};
+
+ActivityReader::ActivityReader() : impl_(new Impl()) {}
+
+ActivityReader::~ActivityReader() = default;
+
+Error ActivityReader::Open(const std::string& path, const ActivityMap& map,
+                           float threshold) {
+  impl_->spans.clear();
+  impl_->span_index = 0;
+  impl_->span_offset = 0;
+  impl_->position = 0;
+  impl_->active_frame_number = 0;
+  auto error = impl_->file.Reopen(path, kIn);
+  if (error != kNoError) {
+    return error;
+  }
+  if (map.frame_number != impl_->file.frame_number()) {
+    impl_->file.Reset();
+    return kInvalidFormat;
+  }
+  impl_->spans = ActiveSpans(map, threshold);
+  for (const auto& span : impl_->spans) {
+    impl_->active_frame_number += span.frame_number;
+  }
+  return kNoError;
+}
+
+Error ActivityReader::Read(uint64_t frame_number, std::vector<float>* output,
+                           uint64_t* frame_index) {
+  if (impl_->span_index == impl_->spans.size()) {
+    return kInvalidFormat;
+  }
+  const auto& span = impl_->spans[impl_->span_index];
+  auto span_frame_index = span.frame_index + impl_->span_offset;
+  // silent frames are skipped
+  if (impl_->file.Tell() != span_frame_index) {
+    auto error = impl_->file.Seek(span_frame_index);
+    if (error != kNoError) {
+      return error;
+    }
+  }
+  auto count = std::min(frame_number, span.frame_number - impl_->span_offset);
+  auto error = impl_->file.Read(count, output);
+  if (error != kNoError) {
+    return error;
+  }
+  *frame_index = span_frame_index;
+  impl_->position += count;
+  impl_->span_offset += count;
+  if (impl_->span_offset == span.frame_number) {
+    impl_->span_index++;
+    impl_->span_offset = 0;
+  }
+  return kNoError;
+}
+
+uint64_t ActivityReader::Tell() const { return impl_->position; }
+
+uint64_t ActivityReader::active_frame_number() const {
+  return impl_->active_frame_number;
+}
+
+const std::vector<Span>& ActivityReader::spans() const {
+  return impl_->spans;
+}
+
+uint16_t ActivityReader::channel_number() const {
+  return impl_->file.channel_number();
+}
+
+uint32_t ActivityReader::sample_rate() const {
+  return impl_->file.sample_rate();
+}
+
+}  // namespace wave
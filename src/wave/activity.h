@@ -0,0 +1,100 @@
+#ifndef WAVE_WAVE_ACTIVITY_H_
+#define WAVE_WAVE_ACTIVITY_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+
+namespace wave {
+
+/**
+ * @brief Level of each block of a file, to skip its silent parts without
+ * decoding them again
+ */
+struct ActivityMap {
+  uint64_t block_frame_number;
+  // frames of the file, the last block may be shorter than the others
+  uint64_t frame_number;
+  // RMS level of each block, all channels together
+  std::vector<float> levels;
+};
+
+/**
+ * @brief Consecutive frames of a file
+ */
+struct Span {
+  uint64_t frame_index;
+  uint64_t frame_number;
+};
+
+/**
+ * @brief Decode the whole file at path once to compute the level of each
+ * block of block_frame_number frames.
+ */
+Error ComputeActivityMap(const std::string& path, uint64_t block_frame_number,
+                         ActivityMap* output);
+
+/**
+ * @brief Store an activity map in a sidecar file, so that it is computed
+ * once per file
+ */
+Error WriteActivityMap(const std::string& path, const ActivityMap& map);
+/**
+ * @return kInvalidFormat if the file at path is not an activity map
+ */
+Error ReadActivityMap(const std::string& path, ActivityMap* output);
+
+/**
+ * @brief Spans of the consecutive blocks whose level is at least threshold,
+ * an RMS level (0.001 for -60 dBFS)
+ */
+std::vector<Span> ActiveSpans(const ActivityMap& map, float threshold);
+
+/**
+ * @brief Read only the active spans of a file, seeking over the silent
+ * ones, so that reading and decoding scale with the active content.
+ */
+class ActivityReader {
+ public:
+  ActivityReader();
+  ~ActivityReader();
+
+  /**
+   * @brief Open the file at path, whose activity is given by map
+   * @note: kInvalidFormat is returned if map was computed on a file of
+   * another length.
+   */
+  Error Open(const std::string& path, const ActivityMap& map, float threshold);
+
+  /**
+   * @brief Read up to frame_number frames of the current span, and move to
+   * the next span once the current one was read. frame_index gets the
+   * position of the first frame read in file.
+   * @note: kInvalidFormat is returned once every span was read, like
+   * File::Read past the end of file.
+   */
+  Error Read(uint64_t frame_number, std::vector<float>* output,
+             uint64_t* frame_index);
+
+  /**
+   * @brief Number of active frames read so far
+   */
+  uint64_t Tell() const;
+
+  // total number of active frames
+  uint64_t active_frame_number() const;
+  const std::vector<Span>& spans() const;
+  uint16_t channel_number() const;
+  uint32_t sample_rate() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_ACTIVITY_H_
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "wave/activity.h"
+#include "wave/test_files.h"
+
+const std::string gResourcePath(TEST_RESOURCES_PATH);
+
+namespace {
+
+const uint64_t kBlockFrameNumber = 1000;
+
+// Stereo samples alternating silence and a tone, active from frame 2500 to
+// 7000 and from 12000 to the end at 15500
+std::vector<float> Gaps() {
+  const uint64_t kFrameNumber = 15500;
+  std::vector<float> content(kFrameNumber * 2, 0.f);
+  for (uint64_t frame = 0; frame < kFrameNumber; frame++) {
+    if ((frame >= 2500 && frame < 7000) || frame >= 12000) {
+      auto sample = 0.5f * std::sin(static_cast<float>(frame) * 0.05f);
+      content[frame * 2] = sample;
+      content[frame * 2 + 1] = -sample;
+    }
+  }
+  return content;
+}
+
+}  // namespace
+
+TEST(Activity, Map) {
+  using namespace wave;
+  auto path = gResourcePath + "/output-activity.wav";
+  auto content = Gaps();
+  ASSERT_EQ(WriteTestFile(path, 2, &content), kNoError);
+  ActivityMap map;
+  ASSERT_EQ(ComputeActivityMap(path, 0, &map), kInvalidFormat);
+  ASSERT_EQ(ComputeActivityMap(path, kBlockFrameNumber, &map), kNoError);
+  ASSERT_EQ(map.block_frame_number, kBlockFrameNumber);
+  ASSERT_EQ(map.frame_number, 15500);
+  ASSERT_EQ(map.levels.size(), 16);
+  ASSERT_EQ(map.levels[0], 0.f);
+  ASSERT_EQ(map.levels[8], 0.f);
+  // a sine of amplitude 0.5, half of block 2 only
+  ASSERT_NEAR(map.levels[4], 0.5f / std::sqrt(2.f), 1e-2);
+  ASSERT_NEAR(map.levels[2], 0.5f / 2.f, 1e-2);
+  ASSERT_NEAR(map.levels[15], 0.5f / std::sqrt(2.f), 2e-2);
+
+  auto spans = ActiveSpans(map, 0.001f);
+  ASSERT_EQ(spans.size(), 2);
+  ASSERT_EQ(spans[0].frame_index, 2000);
+  ASSERT_EQ(spans[0].frame_number, 5000);
+  ASSERT_EQ(spans[1].frame_index, 12000);
+  ASSERT_EQ(spans[1].frame_number, 3500);
+  ASSERT_EQ(ActiveSpans(map, 1.f).size(), 0);
+
+  // sidecar
+  auto sidecar_path = gResourcePath + "/output-activity.wact";
+  ASSERT_EQ(WriteActivityMap(sidecar_path, map), kNoError);
+  ActivityMap read_map;
+  ASSERT_EQ(ReadActivityMap(sidecar_path, &read_map), kNoError);
+  ASSERT_EQ(read_map.block_frame_number, map.block_frame_number);
+  ASSERT_EQ(read_map.frame_number, map.frame_number);
+  ASSERT_EQ(read_map.levels, map.levels);
+  ASSERT_EQ(ReadActivityMap(path, &read_map), kInvalidFormat);
+  ASSERT_EQ(ReadActivityMap(gResourcePath + "/missing.wact", &read_map),
+            kFailedToOpen);
+
+  // block numbers don't overflow
+  ActivityMap large_map;
+  large_map.block_frame_number = std::numeric_limits<uint64_t>::max();
+  large_map.frame_number = std::numeric_limits<uint64_t>::max();
+  large_map.levels = {0.5f};
+  ASSERT_EQ(WriteActivityMap(sidecar_path, large_map), kNoError);
+  ASSERT_EQ(ReadActivityMap(sidecar_path, &read_map), kNoError);
+  ASSERT_EQ(read_map.levels, large_map.levels);
+
+  // levels beyond the end of the file are not allocated
+  large_map.block_frame_number = 1;
+  large_map.levels.clear();
+  ASSERT_EQ(WriteActivityMap(sidecar_path, large_map), kNoError);
+  std::vector<char> header(32);
+  {
+    std::ifstream stream(sidecar_path, std::ios::binary);
+    stream.read(header.data(), header.size());
+  }
+  // block number of the file frame number
+  auto block_number = std::numeric_limits<uint64_t>::max();
+  memcpy(header.data() + 24, &block_number, sizeof(block_number));
+  {
+    std::ofstream stream(sidecar_path, std::ios::binary);
+    stream.write(header.data(), header.size());
+  }
+  ASSERT_EQ(ReadActivityMap(sidecar_path, &read_map), kInvalidFormat);
+}
+
+TEST(Activity, Reader) {
+  using namespace wave;
+  auto path = gResourcePath + "/output-activity.wav";
+  auto content = Gaps();
+  ASSERT_EQ(WriteTestFile(path, 2, &content), kNoError);
+  ActivityMap map;
+  ASSERT_EQ(ComputeActivityMap(path, kBlockFrameNumber, &map), kNoError);
+
+  ActivityReader reader;
+  ASSERT_EQ(reader.Open(path, map, 0.001f), kNoError);
+  ASSERT_EQ(reader.active_frame_number(), 8500);
+  ASSERT_EQ(reader.channel_number(), 2);
+  std::vector<float> frames;
+  uint64_t frame_index = 0;
+  std::vector<uint64_t> frame_indices;
+  while (reader.Tell() < reader.active_frame_number()) {
+    ASSERT_EQ(reader.Read(2048, &frames, &frame_index), kNoError);
+    frame_indices.push_back(frame_index);
+    auto first = content.begin() + frame_index * 2;
+    ASSERT_EQ(frames, std::vector<float>(first, first + frames.size()));
+  }
+  // reads stop at the end of spans
+  ASSERT_EQ(frame_indices,
+            std::vector<uint64_t>({2000, 4048, 6096, 12000, 14048}));
+  ASSERT_EQ(reader.Read(2048, &frames, &frame_index), kInvalidFormat);
+
+  // map of another file
+  map.frame_number++;
+  ASSERT_EQ(reader.Open(path, map, 0.001f), kInvalidFormat);
+}
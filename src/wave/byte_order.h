@@ -0,0 +1,59 @@
+#ifndef WAVE_WAVE_BYTE_ORDER_H_
+#define WAVE_WAVE_BYTE_ORDER_H_
+
+#include <cstdint>
+
+namespace wave {
+namespace internal {
+
+// RIFF files are little-endian, RIFX files are big-endian. Values read from
+// or written to files go through FromFileOrder and ToFileOrder so that both
+// work on little and big-endian hosts.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+const bool kBigEndianHost = true;
+#else
+const bool kBigEndianHost = false;
+#endif
+
+// Written with shifts so that the compiler recognizes them as bswap, and
+// vectorizes them in sample loops (pshufb on x86, rev on ARM)
+inline uint8_t SwapBytes(uint8_t value) { return value; }
+inline uint16_t SwapBytes(uint16_t value) {
+  return static_cast<uint16_t>((value >> 8) | (value << 8));
+}
+inline uint32_t SwapBytes(uint32_t value) {
+  return ((value & 0x000000ffu) << 24) | ((value & 0x0000ff00u) << 8) |
+         ((value & 0x00ff0000u) >> 8) | ((value & 0xff000000u) >> 24);
+}
+inline uint64_t SwapBytes(uint64_t value) {
+  return (static_cast<uint64_t>(SwapBytes(static_cast<uint32_t>(value)))
+          << 32) |
+         SwapBytes(static_cast<uint32_t>(value >> 32));
+}
+inline int8_t SwapBytes(int8_t value) { return value; }
+inline int16_t SwapBytes(int16_t value) {
+  return static_cast<int16_t>(SwapBytes(static_cast<uint16_t>(value)));
+}
+inline int32_t SwapBytes(int32_t value) {
+  return static_cast<int32_t>(SwapBytes(static_cast<uint32_t>(value)));
+}
+inline int64_t SwapBytes(int64_t value) {
+  return static_cast<int64_t>(SwapBytes(static_cast<uint64_t>(value)));
+}
+
+// A value stored in a file of the given byte order to host order
+template <typename T>
+T FromFileOrder(T value, bool big_endian) {
+  return big_endian == kBigEndianHost ? value : SwapBytes(value);
+}
+
+// A value in host order to the byte order of a file
+template <typename T>
+T ToFileOrder(T value, bool big_endian) {
+  return FromFileOrder(value, big_endian);
+}
+
+}  // namespace internal
+}  // namespace wave
+
+#endif  // WAVE_WAVE_BYTE_ORDER_H_
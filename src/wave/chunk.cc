@@ -0,0 +1,288 @@
+#include "wave/chunk.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "wave/byte_order.h"
+
+namespace wave {
+
+namespace {
+
+// size of the fixed part of the bext chunk, before the coding history
+const size_t kBroadcastExtensionSize = 602;
+const size_t kReservedSize = 180;
+
+// size of a cue point in the "cue " chunk
+const size_t kCuePointSize = 24;
+// size of the fixed part of a "ltxt" entry, before its text
+const size_t kLabeledTextSize = 20;
+
+class Reader {
+ public:
+  explicit Reader(const std::vector<char>& content, bool big_endian = false)
+      : content_(content), position_(0), big_endian_(big_endian) {}
+
+  // fixed size text, null terminated when shorter than size
+  std::string Text(size_t size) {
+    auto begin = content_.data() + position_;
+    position_ += size;
+    return std::string(begin, std::find(begin, begin + size, '\0'));
+  }
+
+  template <typename T>
+  T Value() {
+    T value;
+    memcpy(&value, content_.data() + position_, sizeof(T));
+    position_ += sizeof(T);
+    return internal::FromFileOrder(value, big_endian_);
+  }
+
+  void Bytes(void* output, size_t size) {
+    memcpy(output, content_.data() + position_, size);
+    position_ += size;
+  }
+
+  void Skip(size_t size) { position_ += size; }
+
+  std::string Rest() {
+    return Text(content_.size() - position_);
+  }
+
+  size_t left() const { return content_.size() - position_; }
+
+ private:
+  const std::vector<char>& content_;
+  size_t position_;
+  bool big_endian_;
+};
+
+class Writer {
+ public:
+  explicit Writer(bool big_endian = false) : big_endian_(big_endian) {}
+
+  void Text(const std::string& text, size_t size) {
+    auto position = content_.size();
+    content_.resize(position + size, '\0');
+    memcpy(content_.data() + position, text.data(),
+           std::min(text.size(), size));
+  }
+
+  template <typename T>
+  void Value(T value) {
+    value = internal::ToFileOrder(value, big_endian_);
+    Bytes(&value, sizeof(T));
+  }
+
+  void Bytes(const void* data, size_t size) {
+    auto position = content_.size();
+    content_.resize(position + size);
+    memcpy(content_.data() + position, data, size);
+  }
+
+  std::vector<char> content() const { return content_; }
+
+ private:
+  std::vector<char> content_;
+  bool big_endian_;
+};
+
+}  // namespace
+
+BroadcastExtension MakeBroadcastExtension() {
+  BroadcastExtension extension;
+  extension.time_reference = 0;
+  extension.version = 2;
+  memset(extension.umid, 0, sizeof(extension.umid));
+  // loudness values are unset
+  extension.loudness_value = 0x7fff;
+  extension.loudness_range = 0x7fff;
+  extension.max_true_peak_level = 0x7fff;
+  extension.max_momentary_loudness = 0x7fff;
+  extension.max_short_term_loudness = 0x7fff;
+  return extension;
+}
+
+Error ParseBroadcastExtension(const std::vector<char>& content,
+                              BroadcastExtension* output) {
+  if (content.size() < kBroadcastExtensionSize) {
+    return kInvalidFormat;
+  }
+  // "bext" is little-endian, RIFX files included
+  Reader reader(content);
+  output->description = reader.Text(256);
+  output->originator = reader.Text(32);
+  output->originator_reference = reader.Text(32);
+  output->origination_date = reader.Text(10);
+  output->origination_time = reader.Text(8);
+  uint64_t low = reader.Value<uint32_t>();
+  uint64_t high = reader.Value<uint32_t>();
+  output->time_reference = (high << 32) | low;
+  output->version = reader.Value<uint16_t>();
+  reader.Bytes(output->umid, sizeof(output->umid));
+  output->loudness_value = reader.Value<int16_t>();
+  output->loudness_range = reader.Value<int16_t>();
+  output->max_true_peak_level = reader.Value<int16_t>();
+  output->max_momentary_loudness = reader.Value<int16_t>();
+  output->max_short_term_loudness = reader.Value<int16_t>();
+  reader.Skip(kReservedSize);
+  output->coding_history = reader.Rest();
+  return kNoError;
+}
+
+std::vector<char> SerializeBroadcastExtension(
+    const BroadcastExtension& extension) {
+  Writer writer;
+  writer.Text(extension.description, 256);
+  writer.Text(extension.originator, 32);
+  writer.Text(extension.originator_reference, 32);
+  writer.Text(extension.origination_date, 10);
+  writer.Text(extension.origination_time, 8);
+  writer.Value(static_cast<uint32_t>(extension.time_reference & 0xffffffff));
+  writer.Value(static_cast<uint32_t>(extension.time_reference >> 32));
+  writer.Value(extension.version);
+  writer.Bytes(extension.umid, sizeof(extension.umid));
+  writer.Value(extension.loudness_value);
+  writer.Value(extension.loudness_range);
+  writer.Value(extension.max_true_peak_level);
+  writer.Value(extension.max_momentary_loudness);
+  writer.Value(extension.max_short_term_loudness);
+  writer.Text("", kReservedSize);
+  writer.Text(extension.coding_history, extension.coding_history.size());
+  return writer.content();
+}
+
+Error ParseRegions(const std::vector<char>& cue,
+                   const std::vector<char>& associated_data,
+                   uint64_t frame_number, bool big_endian,
+                   std::vector<Region>* output) {
+  Reader cue_reader(cue, big_endian);
+  if (cue_reader.left() < sizeof(uint32_t)) {
+    return kInvalidFormat;
+  }
+  auto cue_point_number = cue_reader.Value<uint32_t>();
+  if (cue_reader.left() / kCuePointSize < cue_point_number) {
+    return kInvalidFormat;
+  }
+  std::vector<Region> regions(cue_point_number);
+  // cue points without ltxt entry
+  std::vector<bool> open_ended(cue_point_number, true);
+  for (auto& region : regions) {
+    region.id = cue_reader.Value<uint32_t>();
+    // position in play order, data chunk ID, chunk start and block start
+    cue_reader.Skip(16);
+    region.frame_index = std::min<uint64_t>(cue_reader.Value<uint32_t>(),
+                                            frame_number);
+    region.frame_number = 0;
+  }
+  auto find = [&regions](uint32_t id) {
+    return std::find_if(regions.begin(), regions.end(),
+                        [id](const Region& region) { return region.id == id; });
+  };
+
+  // entries of the list are chunks, following the list type
+  Reader list_reader(associated_data, big_endian);
+  if (list_reader.left() >= 4 && list_reader.Text(4) == "adtl") {
+    while (list_reader.left() >= 8) {
+      auto id = list_reader.Text(4);
+      auto size = list_reader.Value<uint32_t>();
+      if (list_reader.left() < size) {
+        return kInvalidFormat;
+      }
+      std::vector<char> entry(size);
+      list_reader.Bytes(entry.data(), size);
+      list_reader.Skip(std::min<size_t>(size & 1, list_reader.left()));
+
+      Reader entry_reader(entry, big_endian);
+      if (entry.size() < sizeof(uint32_t)) {
+        return kInvalidFormat;
+      }
+      auto region = find(entry_reader.Value<uint32_t>());
+      if (region == regions.end()) {
+        continue;
+      }
+      if (id == "labl") {
+        region->label = entry_reader.Rest();
+      } else if (id == "ltxt") {
+        if (entry.size() < kLabeledTextSize) {
+          return kInvalidFormat;
+        }
+        region->frame_number = entry_reader.Value<uint32_t>();
+        open_ended[region - regions.begin()] = false;
+      }
+    }
+  }
+
+  // cut to the end of file, or extend to the next cue point
+  std::vector<uint64_t> starts;
+  for (auto& region : regions) {
+    starts.push_back(region.frame_index);
+  }
+  std::sort(starts.begin(), starts.end());
+  for (size_t idx = 0; idx < regions.size(); idx++) {
+    auto& region = regions[idx];
+    auto end = frame_number;
+    if (open_ended[idx]) {
+      auto next = std::upper_bound(starts.begin(), starts.end(),
+                                   region.frame_index);
+      if (next != starts.end()) {
+        end = *next;
+      }
+    }
+    region.frame_number =
+        open_ended[idx]
+            ? end - region.frame_index
+            : std::min(region.frame_number, end - region.frame_index);
+  }
+  std::stable_sort(regions.begin(), regions.end(),
+                   [](const Region& lhs, const Region& rhs) {
+                     return lhs.frame_index < rhs.frame_index;
+                   });
+  *output = regions;
+  return kNoError;
+}
+
+std::vector<char> SerializeCuePoints(const std::vector<Region>& regions,
+                                     bool big_endian) {
+  Writer writer(big_endian);
+  writer.Value(static_cast<uint32_t>(regions.size()));
+  for (const auto& region : regions) {
+    auto frame_index = static_cast<uint32_t>(region.frame_index);
+    writer.Value(region.id);
+    // position in play order, without playlist
+    writer.Value(frame_index);
+    writer.Bytes("data", 4);
+    // chunk start and block start, 0 for uncompressed data
+    writer.Value(static_cast<uint32_t>(0));
+    writer.Value(static_cast<uint32_t>(0));
+    writer.Value(frame_index);
+  }
+  return writer.content();
+}
+
+std::vector<char> SerializeAssociatedData(const std::vector<Region>& regions,
+                                          bool big_endian) {
+  Writer writer(big_endian);
+  writer.Bytes("adtl", 4);
+  for (const auto& region : regions) {
+    if (!region.label.empty()) {
+      // null terminated label, padded to an even size
+      auto size = static_cast<uint32_t>(sizeof(uint32_t) +
+                                        region.label.size() + 1);
+      writer.Bytes("labl", 4);
+      writer.Value(size);
+      writer.Value(region.id);
+      writer.Text(region.label, region.label.size() + 1 + (size & 1));
+    }
+    writer.Bytes("ltxt", 4);
+    writer.Value(static_cast<uint32_t>(kLabeledTextSize));
+    writer.Value(region.id);
+    writer.Value(static_cast<uint32_t>(region.frame_number));
+    writer.Bytes("rgn ", 4);
+    // country, language, dialect and code page
+    writer.Text("", 8);
+  }
+  return writer.content();
+}
+
+}  // namespace wave
@@ -0,0 +1,79 @@
+#ifndef WAVE_WAVE_CHUNK_H_
+#define WAVE_WAVE_CHUNK_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+
+namespace wave {
+
+/**
+ * @brief Content of the "bext" chunk of broadcast wave files (EBU Tech 3285).
+ * Text fields longer than their fixed size in the chunk get truncated.
+ */
+struct BroadcastExtension {
+  std::string description;           // 256 bytes
+  std::string originator;            // 32 bytes
+  std::string originator_reference;  // 32 bytes
+  std::string origination_date;      // 10 bytes, yyyy:mm:dd
+  std::string origination_time;      // 8 bytes, hh:mm:ss
+  // first sample count since midnight
+  uint64_t time_reference;
+  uint16_t version;
+  uint8_t umid[64];
+  int16_t loudness_value;
+  int16_t loudness_range;
+  int16_t max_true_peak_level;
+  int16_t max_momentary_loudness;
+  int16_t max_short_term_loudness;
+  std::string coding_history;
+};
+BroadcastExtension MakeBroadcastExtension();
+
+/**
+ * @brief Decode the content of a "bext" chunk.
+ * @return kInvalidFormat if content is too small
+ */
+Error ParseBroadcastExtension(const std::vector<char>& content,
+                              BroadcastExtension* output);
+std::vector<char> SerializeBroadcastExtension(
+    const BroadcastExtension& extension);
+
+/**
+ * @brief A region of samples, starting at a cue point of the "cue " chunk.
+ * Its length and label come from the "ltxt" and "labl" entries with the same
+ * id in the associated data list ("LIST" chunk of type "adtl"). Cue points
+ * without length extend to the next cue point, or to the end of the samples.
+ */
+struct Region {
+  // cue point id
+  uint32_t id;
+  uint64_t frame_index;
+  uint64_t frame_number;
+  std::string label;
+};
+
+/**
+ * @brief Decode the content of a "cue " chunk and of an "adtl" "LIST" chunk,
+ * which can be empty, into regions sorted by first frame. frame_number is
+ * the number of frames of the file, regions are cut to it. Values are
+ * big-endian when big_endian is set, in RIFX files.
+ * @return kInvalidFormat if a chunk is truncated
+ */
+Error ParseRegions(const std::vector<char>& cue,
+                   const std::vector<char>& associated_data,
+                   uint64_t frame_number, bool big_endian,
+                   std::vector<Region>* output);
+/**
+ * @brief Contents of the "cue " and "LIST" chunks defining regions
+ */
+std::vector<char> SerializeCuePoints(const std::vector<Region>& regions,
+                                     bool big_endian = false);
+std::vector<char> SerializeAssociatedData(const std::vector<Region>& regions,
+                                          bool big_endian = false);
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_CHUNK_H_
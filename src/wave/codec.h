@@ -0,0 +1,547 @@
+#ifndef WAVE_WAVE_CODEC_H_
+#define WAVE_WAVE_CODEC_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "wave/byte_order.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace wave {
+namespace internal {
+
+// Conversion between the integer samples stored in files and the samples
+// given to users. Each pair of stored and user types has its own loop, with
+// no intermediate type, so that the compiler can vectorize it.
+
+// Integer samples stored on all their bytes, big-endian in RIFX files. Bytes
+// are swapped in the conversion loops, as samples are loaded and stored.
+template <typename T, bool kBigEndian = false>
+struct IntegerStorage {
+  static const int kBits = sizeof(T) * 8;
+  static const size_t kSize = sizeof(T);
+  // stored the way the host stores T
+  static const bool kHostOrder = kBigEndian == kBigEndianHost;
+  static int32_t Load(const char* data) {
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return kHostOrder ? value : SwapBytes(value);
+  }
+  static void Store(int32_t value, char* data) {
+    T stored = static_cast<T>(value);
+    if (!kHostOrder) {
+      stored = SwapBytes(stored);
+    }
+    memcpy(data, &stored, sizeof(T));
+  }
+};
+
+// 24bits int doesn't exist in c++. We read and write 3 * 8bits
+template <bool kBigEndian = false>
+struct Int24Storage {
+  static const int kBits = 24;
+  static const size_t kSize = 3;
+  static const bool kHostOrder = false;
+  // index of the least and most significant bytes
+  static const int kLow = kBigEndian ? 2 : 0;
+  static const int kHigh = kBigEndian ? 0 : 2;
+  static int32_t Load(const char* data) {
+    auto value = reinterpret_cast<const unsigned char*>(data);
+    // check if value is negative
+    if (value[kHigh] & 0x80) {
+      return (0xff << 24) | (value[kHigh] << 16) | (value[1] << 8) |
+             value[kLow];
+    }
+    return (value[kHigh] << 16) | (value[1] << 8) | value[kLow];
+  }
+  static void Store(int32_t value, char* data) {
+    data[kLow] = static_cast<char>(value & 0xff);
+    data[1] = static_cast<char>((value >> 8) & 0xff);
+    data[kHigh] = static_cast<char>((value >> 16) & 0xff);
+  }
+};
+
+// largest value of a signed integer of given bits
+template <int kBits>
+struct IntegerMax {
+  static const int32_t value =
+      static_cast<int32_t>((static_cast<int64_t>(1) << (kBits - 1)) - 1);
+};
+
+template <typename T>
+T Clip(T sample) {
+  if (sample > 1) {
+    return 1;
+  } else if (sample < -1) {
+    return -1;
+  }
+  return sample;
+}
+
+// Integers of kFromBits to kToBits, keeping the most significant bits
+template <int kFromBits, int kToBits>
+int32_t Rescale(int32_t value) {
+  const int up = kToBits > kFromBits ? kToBits - kFromBits : 0;
+  const int down = kFromBits > kToBits ? kFromBits - kToBits : 0;
+  return static_cast<int32_t>(
+      (static_cast<int64_t>(value) * (static_cast<int64_t>(1) << up)) >> down);
+}
+
+// A stored sample of kBits to T, floating point values are in [-1, 1]
+template <typename T, int kBits>
+T FromStored(int32_t value) {
+  if (std::is_floating_point<T>::value) {
+    return static_cast<T>(value) / static_cast<T>(IntegerMax<kBits>::value);
+  }
+  return static_cast<T>(Rescale<kBits, sizeof(T) * 8>(value));
+}
+
+template <typename T, int kBits>
+int32_t ToStored(T sample, bool clip) {
+  if (std::is_floating_point<T>::value) {
+    auto value = clip ? Clip(sample) : sample;
+    return static_cast<int32_t>(value *
+                                static_cast<T>(IntegerMax<kBits>::value));
+  }
+  return Rescale<sizeof(T) * 8, kBits>(static_cast<int32_t>(sample));
+}
+
+template <typename T, typename Storage>
+void DecodeAs(const char* data, size_t sample_number, T* output) {
+  // nothing to convert, samples are copied as they are
+  if (std::is_integral<T>::value && sizeof(T) == Storage::kSize &&
+      Storage::kBits == sizeof(T) * 8 && Storage::kHostOrder) {
+    memcpy(output, data, sample_number * sizeof(T));
+    return;
+  }
+  for (size_t sample_idx = 0; sample_idx < sample_number; sample_idx++) {
+    output[sample_idx] = FromStored<T, Storage::kBits>(
+        Storage::Load(data + sample_idx * Storage::kSize));
+  }
+}
+
+template <typename T, typename Storage>
+void EncodeAs(const T* data, size_t sample_number, bool clip, char* output) {
+  if (std::is_integral<T>::value && sizeof(T) == Storage::kSize &&
+      Storage::kBits == sizeof(T) * 8 && Storage::kHostOrder) {
+    memcpy(output, data, sample_number * sizeof(T));
+    return;
+  }
+  for (size_t sample_idx = 0; sample_idx < sample_number; sample_idx++) {
+    Storage::Store(ToStored<T, Storage::kBits>(data[sample_idx], clip),
+                   output + sample_idx * Storage::kSize);
+  }
+}
+
+template <typename T, bool kBigEndian>
+void DecodeOrdered(const char* data, uint16_t bits_per_sample,
+                   size_t sample_number, T* output) {
+  switch (bits_per_sample) {
+    case 8:
+      return DecodeAs<T, IntegerStorage<int8_t>>(data, sample_number, output);
+    case 16:
+      return DecodeAs<T, IntegerStorage<int16_t, kBigEndian>>(
+          data, sample_number, output);
+    case 24:
+      return DecodeAs<T, Int24Storage<kBigEndian>>(data, sample_number,
+                                                   output);
+    case 32:
+      return DecodeAs<T, IntegerStorage<int32_t, kBigEndian>>(
+          data, sample_number, output);
+  }
+}
+
+// Decode sample_number samples of bits_per_sample bits to T. Samples are
+// big-endian in RIFX files
+template <typename T>
+void Decode(const char* data, uint16_t bits_per_sample, size_t sample_number,
+            T* output, bool big_endian = false) {
+  if (big_endian) {
+    return DecodeOrdered<T, true>(data, bits_per_sample, sample_number,
+                                  output);
+  }
+  DecodeOrdered<T, false>(data, bits_per_sample, sample_number, output);
+}
+
+template <typename T, bool kBigEndian>
+void EncodeOrdered(const T* data, size_t sample_number,
+                   uint16_t bits_per_sample, bool clip, char* output) {
+  switch (bits_per_sample) {
+    case 8:
+      return EncodeAs<T, IntegerStorage<int8_t>>(data, sample_number, clip,
+                                                 output);
+    case 16:
+      return EncodeAs<T, IntegerStorage<int16_t, kBigEndian>>(
+          data, sample_number, clip, output);
+    case 24:
+      return EncodeAs<T, Int24Storage<kBigEndian>>(data, sample_number, clip,
+                                                   output);
+    case 32:
+      return EncodeAs<T, IntegerStorage<int32_t, kBigEndian>>(
+          data, sample_number, clip, output);
+  }
+}
+
+// Encode sample_number samples of T to bits_per_sample bits. clip only
+// applies to floating point samples
+template <typename T>
+void Encode(const T* data, size_t sample_number, uint16_t bits_per_sample,
+            bool clip, char* output, bool big_endian = false) {
+  if (big_endian) {
+    return EncodeOrdered<T, true>(data, sample_number, bits_per_sample, clip,
+                                  output);
+  }
+  EncodeOrdered<T, false>(data, sample_number, bits_per_sample, clip,
+                          output);
+}
+
+// Channels are processed one after the other when they don't fit in lanes
+template <typename T>
+void ApplyGainByChannels(T* samples, size_t sample_number,
+                         size_t channel_number, size_t first_channel,
+                         const float* gains, float* peaks,
+                         double* sums_of_squares) {
+  for (size_t channel = 0; channel < channel_number; channel++) {
+    auto start = (channel + channel_number - first_channel) % channel_number;
+    auto gain = static_cast<T>(gains[channel]);
+    T peak = 0;
+    double sum_of_squares = 0.;
+    for (size_t idx = start; idx < sample_number; idx += channel_number) {
+      T sample = samples[idx] * gain;
+      samples[idx] = sample;
+      if (peaks != nullptr) {
+        T magnitude = sample < 0 ? -sample : sample;
+        peak = magnitude > peak ? magnitude : peak;
+        sum_of_squares += static_cast<double>(sample) * sample;
+      }
+    }
+    if (peaks != nullptr) {
+      peaks[channel] = std::max(peaks[channel], static_cast<float>(peak));
+      sums_of_squares[channel] += sum_of_squares;
+    }
+  }
+}
+
+// Multiply lane_number samples by lane_gains and accumulate the peak and
+// sum of squares of each lane, lane_number being a multiple of kLanes
+template <typename T, size_t kLanes>
+void AccumulateLevels(T* samples, size_t lane_number, const T* lane_gains,
+                      T* lane_peaks, double* lane_sums) {
+  for (size_t idx = 0; idx < lane_number; idx += kLanes) {
+    for (size_t lane = 0; lane < kLanes; lane++) {
+      T sample = samples[idx + lane] * lane_gains[lane];
+      samples[idx + lane] = sample;
+      lane_peaks[lane] = std::max(lane_peaks[lane], std::abs(sample));
+      lane_sums[lane] += static_cast<double>(sample) * sample;
+    }
+  }
+}
+
+#ifdef __SSE2__
+// The compiler keeps the lanes of the generic version in scalar registers,
+// float samples are the common case so their lanes are vectorized here
+template <>
+inline void AccumulateLevels<float, 8>(float* samples, size_t lane_number,
+                                       const float* lane_gains,
+                                       float* lane_peaks, double* lane_sums) {
+  const __m128 sign = _mm_set1_ps(-0.f);
+  __m128 gains[2] = {_mm_loadu_ps(lane_gains), _mm_loadu_ps(lane_gains + 4)};
+  __m128 peaks[2] = {_mm_loadu_ps(lane_peaks), _mm_loadu_ps(lane_peaks + 4)};
+  __m128d sums[4] = {_mm_loadu_pd(lane_sums), _mm_loadu_pd(lane_sums + 2),
+                     _mm_loadu_pd(lane_sums + 4), _mm_loadu_pd(lane_sums + 6)};
+  for (size_t idx = 0; idx < lane_number; idx += 8) {
+    for (size_t half = 0; half < 2; half++) {
+      auto sample = _mm_mul_ps(_mm_loadu_ps(samples + idx + 4 * half),
+                               gains[half]);
+      _mm_storeu_ps(samples + idx + 4 * half, sample);
+      peaks[half] = _mm_max_ps(peaks[half], _mm_andnot_ps(sign, sample));
+      auto low = _mm_cvtps_pd(sample);
+      auto high = _mm_cvtps_pd(_mm_movehl_ps(sample, sample));
+      sums[2 * half] = _mm_add_pd(sums[2 * half], _mm_mul_pd(low, low));
+      sums[2 * half + 1] =
+          _mm_add_pd(sums[2 * half + 1], _mm_mul_pd(high, high));
+    }
+  }
+  for (size_t half = 0; half < 2; half++) {
+    _mm_storeu_ps(lane_peaks + 4 * half, peaks[half]);
+    _mm_storeu_pd(lane_sums + 4 * half, sums[2 * half]);
+    _mm_storeu_pd(lane_sums + 4 * half + 2, sums[2 * half + 1]);
+  }
+}
+#endif  // __SSE2__
+
+// Samples are processed kLanes at once, each lane having its own gain and
+// accumulators, so that the loop can be vectorized. kLanes has to be a
+// multiple of the channel number. Remaining samples go through
+// ApplyGainByChannels.
+template <typename T, size_t kLanes>
+void ApplyGainByLanes(T* samples, size_t sample_number, size_t channel_number,
+                      size_t first_channel, const float* gains, float* peaks,
+                      double* sums_of_squares) {
+  T lane_gains[kLanes];
+  for (size_t lane = 0; lane < kLanes; lane++) {
+    lane_gains[lane] =
+        static_cast<T>(gains[(first_channel + lane) % channel_number]);
+  }
+  auto lane_end = sample_number - sample_number % kLanes;
+  if (peaks == nullptr) {
+    for (size_t idx = 0; idx < lane_end; idx += kLanes) {
+      for (size_t lane = 0; lane < kLanes; lane++) {
+        samples[idx + lane] *= lane_gains[lane];
+      }
+    }
+  } else {
+    T lane_peaks[kLanes] = {};
+    double lane_sums[kLanes] = {};
+    AccumulateLevels<T, kLanes>(samples, lane_end, lane_gains, lane_peaks,
+                                lane_sums);
+    for (size_t lane = 0; lane < kLanes; lane++) {
+      auto channel = (first_channel + lane) % channel_number;
+      peaks[channel] =
+          std::max(peaks[channel], static_cast<float>(lane_peaks[lane]));
+      sums_of_squares[channel] += lane_sums[lane];
+    }
+  }
+  ApplyGainByChannels(samples + lane_end, sample_number - lane_end,
+                      channel_number,
+                      (first_channel + lane_end) % channel_number, gains,
+                      peaks, sums_of_squares);
+}
+
+// Multiply samples by the gain of their channel and, when peaks is set,
+// accumulate the peak and sum of squares of each channel. samples start at
+// channel first_channel.
+template <typename T>
+void ApplyGain(T* samples, size_t sample_number, size_t channel_number,
+               size_t first_channel, const float* gains, float* peaks,
+               double* sums_of_squares) {
+  const size_t kLanes = 8;
+  if (kLanes % channel_number == 0) {
+    ApplyGainByLanes<T, kLanes>(samples, sample_number, channel_number,
+                                first_channel, gains, peaks,
+                                sums_of_squares);
+  } else {
+    ApplyGainByChannels(samples, sample_number, channel_number,
+                        first_channel, gains, peaks, sums_of_squares);
+  }
+}
+
+// Integer hash of 32 bits (lowbias32 by Chris Wellons)
+inline uint32_t Hash(uint32_t value) {
+  value ^= value >> 16;
+  value *= 0x7feb352du;
+  value ^= value >> 15;
+  value *= 0x846ca68bu;
+  value ^= value >> 16;
+  return value;
+}
+
+// Triangular noise in ]-1, 1[ of the samples of a file, as the difference
+// of two uniform values of 16 bits, the halves of the hash of the sample
+// index and seed. There is no state, so that the noise of a sample doesn't
+// depend on how samples are split between writes, and the loops drawing it
+// are vectorized. Indices are hashed on 32 bits, their high bits go to the
+// key.
+struct TPDFNoise {
+  TPDFNoise(uint64_t seed, uint64_t sample_index)
+      : key(Hash(static_cast<uint32_t>(seed) ^
+                 Hash(static_cast<uint32_t>(seed >> 32) ^
+                      Hash(static_cast<uint32_t>(sample_index >> 32))))),
+        first(static_cast<uint32_t>(sample_index)) {}
+
+  // noise of the sample idx samples after sample_index, within the same
+  // 2^32 samples
+  float operator()(size_t idx) const {
+    auto hash = Hash((first + static_cast<uint32_t>(idx)) ^ key);
+    auto difference = static_cast<int32_t>(hash & 0xffff) -
+                      static_cast<int32_t>(hash >> 16);
+    return static_cast<float>(difference) * (1.f / (1 << 16));
+  }
+
+  uint32_t key;
+  uint32_t first;
+};
+
+// Round to the nearest integer, for values below 2^22 (float) or 2^51
+// (double) in magnitude. Unlike std::round, the loops using it are
+// vectorized.
+template <typename T>
+T RoundNearest(T value) {
+  const T kMagic = sizeof(T) == sizeof(float) ? static_cast<T>(12582912.)
+                                              : static_cast<T>(6755399441055744.);
+  return (value + kMagic) - kMagic;
+}
+
+// Quantize floating point samples to kBits after adding noise, in least
+// significant bits, rounding to the nearest value. With errors, the
+// quantization error of each channel is subtracted from its next sample,
+// which moves the noise to high frequencies (first order noise shaping).
+// samples start at channel first_channel.
+template <typename T, typename Storage>
+void EncodeDitheredAs(const T* data, size_t sample_number, bool clip,
+                      const TPDFNoise& noise, size_t channel_number,
+                      size_t first_channel, float* errors, char* output) {
+  // only floating point samples are dithered, integers compile to the same
+  // code for float
+  typedef typename std::conditional<std::is_floating_point<T>::value, T,
+                                    float>::type Float;
+  const Float kMax = static_cast<Float>(IntegerMax<Storage::kBits>::value);
+  const Float kMin = -kMax - 1;
+  if (errors == nullptr) {
+    for (size_t idx = 0; idx < sample_number; idx++) {
+      Float sample = static_cast<Float>(data[idx]);
+      Float value = (clip ? Clip(sample) : sample) * kMax + noise(idx);
+      value = std::min(std::max(RoundNearest(value), kMin), kMax);
+      Storage::Store(static_cast<int32_t>(value),
+                     output + idx * Storage::kSize);
+    }
+    return;
+  }
+  // each sample depends on the previous one of its channel
+  auto channel = first_channel;
+  for (size_t idx = 0; idx < sample_number; idx++) {
+    Float sample = static_cast<Float>(data[idx]);
+    Float wanted = (clip ? Clip(sample) : sample) * kMax - errors[channel];
+    Float value =
+        std::min(std::max(RoundNearest(wanted + noise(idx)), kMin), kMax);
+    // bounded when samples get clipped, the error is below 1.5 otherwise
+    errors[channel] =
+        std::min(std::max(static_cast<float>(value - wanted), -1.5f), 1.5f);
+    Storage::Store(static_cast<int32_t>(value), output + idx * Storage::kSize);
+    if (++channel == channel_number) {
+      channel = 0;
+    }
+  }
+}
+
+template <typename T, typename Storage>
+void EncodeDitheredAs(const T* data, size_t sample_number, bool clip,
+                      uint64_t seed, uint64_t sample_index,
+                      size_t channel_number, size_t first_channel,
+                      float* errors, char* output) {
+  // the noise key changes every 2^32 samples
+  const uint64_t kSegment = static_cast<uint64_t>(1) << 32;
+  while (sample_number > 0) {
+    auto count = static_cast<size_t>(std::min<uint64_t>(
+        sample_number, kSegment - sample_index % kSegment));
+    EncodeDitheredAs<T, Storage>(data, count, clip,
+                                 TPDFNoise(seed, sample_index),
+                                 channel_number, first_channel, errors,
+                                 output);
+    data += count;
+    output += count * Storage::kSize;
+    sample_index += count;
+    first_channel = (first_channel + count) % channel_number;
+    sample_number -= count;
+  }
+}
+
+// Dithered version of Encode for 8 and 16 bits, see EncodeDitheredAs.
+// sample_index is the index of the first sample in file.
+template <typename T>
+void EncodeDithered(const T* data, size_t sample_number,
+                    uint16_t bits_per_sample, bool clip, uint64_t seed,
+                    uint64_t sample_index, size_t channel_number,
+                    size_t first_channel, float* errors, char* output,
+                    bool big_endian = false) {
+  if (bits_per_sample == 8) {
+    return EncodeDitheredAs<T, IntegerStorage<int8_t>>(
+        data, sample_number, clip, seed, sample_index, channel_number,
+        first_channel, errors, output);
+  }
+  if (big_endian) {
+    return EncodeDitheredAs<T, IntegerStorage<int16_t, true>>(
+        data, sample_number, clip, seed, sample_index, channel_number,
+        first_channel, errors, output);
+  }
+  EncodeDitheredAs<T, IntegerStorage<int16_t>>(
+      data, sample_number, clip, seed, sample_index, channel_number,
+      first_channel, errors, output);
+}
+
+// Sum of the squares of sample_number samples, accumulated in float lanes
+// so that the loop is vectorized
+inline float SumOfSquares(const float* samples, size_t sample_number) {
+  size_t idx = 0;
+  float sum = 0.f;
+#ifdef __SSE2__
+  __m128 sums[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+  for (; idx + 8 <= sample_number; idx += 8) {
+    for (size_t half = 0; half < 2; half++) {
+      auto sample = _mm_loadu_ps(samples + idx + 4 * half);
+      sums[half] = _mm_add_ps(sums[half], _mm_mul_ps(sample, sample));
+    }
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, _mm_add_ps(sums[0], sums[1]));
+  sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif  // __SSE2__
+  for (; idx < sample_number; idx++) {
+    sum += samples[idx] * samples[idx];
+  }
+  return sum;
+}
+
+// Number of frames mixed at once by Mix
+const size_t kMixFrames = 16;
+
+// Mix frame_number interleaved frames of input_channel_number channels into
+// output_channel_number channels. matrix is row major, a row of
+// input_channel_number coefficients for each output channel. Frames are
+// deinterleaved kMixFrames at once in scratch, which holds
+// (input_channel_number + output_channel_number) * kMixFrames samples, so
+// that multiplies and adds are vectorized over frames.
+template <typename T>
+void Mix(const T* input, size_t frame_number, size_t input_channel_number,
+         const float* matrix, size_t output_channel_number, T* scratch,
+         T* output) {
+  auto planar_input = scratch;
+  auto planar_output = scratch + input_channel_number * kMixFrames;
+  for (size_t first_frame = 0; first_frame < frame_number;
+       first_frame += kMixFrames) {
+    auto count = std::min(kMixFrames, frame_number - first_frame);
+    auto frames = input + first_frame * input_channel_number;
+    for (size_t frame = 0; frame < count; frame++) {
+      for (size_t channel = 0; channel < input_channel_number; channel++) {
+        planar_input[channel * kMixFrames + frame] =
+            frames[frame * input_channel_number + channel];
+      }
+    }
+    for (size_t output_channel = 0; output_channel < output_channel_number;
+         output_channel++) {
+      auto mixed = planar_output + output_channel * kMixFrames;
+      auto row = matrix + output_channel * input_channel_number;
+      std::fill(mixed, mixed + kMixFrames, T(0));
+      for (size_t channel = 0; channel < input_channel_number; channel++) {
+        // channels left out of the mix, like LFE in downmixes
+        if (row[channel] == 0) {
+          continue;
+        }
+        auto coefficient = static_cast<T>(row[channel]);
+        auto samples = planar_input + channel * kMixFrames;
+        for (size_t frame = 0; frame < kMixFrames; frame++) {
+          mixed[frame] += coefficient * samples[frame];
+        }
+      }
+    }
+    auto mixed_frames = output + first_frame * output_channel_number;
+    for (size_t frame = 0; frame < count; frame++) {
+      for (size_t output_channel = 0; output_channel < output_channel_number;
+           output_channel++) {
+        mixed_frames[frame * output_channel_number + output_channel] =
+            planar_output[output_channel * kMixFrames + frame];
+      }
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace wave
+
+#endif  // WAVE_WAVE_CODEC_H_
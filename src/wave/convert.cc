@@ -0,0 +1,414 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "wave/file.h"
+#include "wave/io/file_copy.h"
+#include "wave/thread_pool.h"
+
+namespace {
+
+struct Options {
+  Options()
+      : bits_per_sample(0),
+        channel_number(0),
+        big_endian(false),
+        dither(wave::kNoDither),
+        thread_number(0),
+        block_frame_number(65536) {}
+
+  // 0 keeps the value of each input
+  uint16_t bits_per_sample;
+  uint16_t channel_number;
+  bool big_endian;
+  wave::Dither dither;
+  size_t thread_number;
+  // frames each worker reads and writes at once, which bounds its buffers
+  uint64_t block_frame_number;
+  std::string output_directory;
+  std::vector<std::string> inputs;
+};
+
+// What a worker reports for a file
+struct Result {
+  Result()
+      : error(wave::kNoError),
+        frame_number(0),
+        byte_number(0),
+        duration(0),
+        seconds(0) {}
+
+  wave::Error error;
+  uint64_t frame_number;
+  // samples read, as stored in the input
+  uint64_t byte_number;
+  // audio duration in seconds
+  double duration;
+  // from open to close
+  double seconds;
+};
+
+const char* ErrorName(wave::Error error) {
+  switch (error) {
+    case wave::kNoError:
+      return "no error";
+    case wave::kFailedToOpen:
+      return "failed to open";
+    case wave::kNotOpen:
+      return "not open";
+    case wave::kInvalidFormat:
+      return "invalid format";
+    case wave::kWriteError:
+      return "write error";
+    case wave::kReadError:
+      return "read error";
+    case wave::kInvalidSeek:
+      return "invalid seek";
+    case wave::kChunkNotFound:
+      return "chunk not found";
+    case wave::kInvalidChecksum:
+      return "invalid checksum";
+  }
+  return "unknown error";
+}
+
+bool IsWave(const std::string& name) {
+  if (name.size() < 4) {
+    return false;
+  }
+  auto extension = name.substr(name.size() - 4);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](char c) { return static_cast<char>(std::tolower(c)); });
+  return extension == ".wav";
+}
+
+std::string FileName(const std::string& path) {
+  auto separator = path.find_last_of("/\\");
+  return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+// Add the WAVE files of directory to paths, or false if path isn't a
+// directory
+bool ListDirectory(const std::string& directory,
+                   std::vector<std::string>* paths) {
+  std::vector<std::string> names;
+#ifdef _WIN32
+  WIN32_FIND_DATAA data;
+  auto handle = FindFirstFileA((directory + "\\*").c_str(), &data);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  do {
+    if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+      names.push_back(data.cFileName);
+    }
+  } while (FindNextFileA(handle, &data));
+  FindClose(handle);
+#else
+  auto dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    return false;
+  }
+  while (auto entry = readdir(dir)) {
+    struct stat info;
+    auto path = directory + "/" + entry->d_name;
+    if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+#endif
+  std::sort(names.begin(), names.end());
+  for (const auto& name : names) {
+    if (IsWave(name)) {
+      paths->push_back(directory + "/" + name);
+    }
+  }
+  return true;
+}
+
+wave::Error Convert(const Options& options, const std::string& input_path,
+                    const std::string& output_path, std::vector<float>* block,
+                    std::vector<char>* raw_block, Result* result) {
+  // opening the output would truncate the input, whatever the way the paths
+  // are spelled
+  if (output_path == input_path || wave::SameFile(output_path, input_path)) {
+    return wave::kFailedToOpen;
+  }
+  wave::File input;
+  auto error = input.Open(input_path, wave::kIn);
+  if (error != wave::kNoError) {
+    return error;
+  }
+  auto bits_per_sample =
+      options.bits_per_sample == 0 ? input.bits_per_sample()
+                                   : options.bits_per_sample;
+  auto channel_number =
+      options.channel_number == 0 ? input.channel_number()
+                                  : options.channel_number;
+  if (channel_number != input.channel_number()) {
+    auto matrix = wave::DownmixMatrix(input.channel_number(), channel_number);
+    if (matrix.empty()) {
+      return wave::kInvalidFormat;
+    }
+    input.set_mix_matrix(matrix);
+  }
+
+  wave::File output;
+  error = output.Open(output_path, wave::kOut);
+  if (error != wave::kNoError) {
+    return error;
+  }
+  output.set_sample_rate(input.sample_rate());
+  output.set_channel_number(channel_number);
+  output.set_bits_per_sample(bits_per_sample);
+  output.set_big_endian(options.big_endian);
+  output.set_dither(options.dither);
+  output.set_expected_frame_number(input.frame_number());
+
+  // samples are copied as stored when the format doesn't change
+  auto raw = bits_per_sample == input.bits_per_sample() &&
+             channel_number == input.channel_number() &&
+             options.big_endian == input.big_endian();
+  result->frame_number = input.frame_number();
+  result->byte_number = input.frame_number() * input.channel_number() *
+                        (input.bits_per_sample() / 8);
+  result->duration = static_cast<double>(input.frame_number()) /
+                     std::max<uint32_t>(input.sample_rate(), 1);
+
+  for (uint64_t frame_index = 0; frame_index < input.frame_number();
+       frame_index += options.block_frame_number) {
+    auto frame_number = std::min(options.block_frame_number,
+                                 input.frame_number() - frame_index);
+    if (raw) {
+      error = input.ReadRaw(frame_number, raw_block);
+      if (error == wave::kNoError) {
+        error = output.WriteRaw(*raw_block);
+      }
+    } else {
+      error = input.Read(frame_number, block);
+      if (error == wave::kNoError) {
+        error = output.Write(*block);
+      }
+    }
+    if (error != wave::kNoError) {
+      return error;
+    }
+  }
+
+  // metadata chunks follow the samples
+  std::vector<char> content;
+  for (const auto& id : input.chunk_ids()) {
+    error = input.ReadChunk(id, &content);
+    if (error == wave::kNoError) {
+      error = output.WriteChunk(id, content);
+    }
+    if (error != wave::kNoError) {
+      return error;
+    }
+  }
+  // the headers and chunks are only written once the output is closed
+  return output.Close();
+}
+
+void PrintUsage() {
+  std::cerr
+      << "usage: wave_convert [options] -o directory input...\n"
+         "Convert WAVE files, or the WAVE files of input directories, to\n"
+         "files of the same name in the output directory.\n"
+         "  -b bits       bits per sample: 8, 16, 24 or 32\n"
+         "  -c channels   channel number, see wave::DownmixMatrix\n"
+         "  -e            write big-endian (RIFX) files\n"
+         "  -d dither     none, tpdf or shaped, for 8 and 16 bits\n"
+         "  -j threads    number of files converted at once, one per core "
+         "by default\n"
+         "  -f frames     frames read and written at once, 65536 by "
+         "default\n";
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int idx = 1; idx < argc; idx++) {
+    std::string argument = argv[idx];
+    if (argument.size() != 2 || argument[0] != '-') {
+      options->inputs.push_back(argument);
+      continue;
+    }
+    if (argument == "-e") {
+      options->big_endian = true;
+      continue;
+    }
+    if (idx + 1 == argc) {
+      return false;
+    }
+    std::string value = argv[++idx];
+    switch (argument[1]) {
+      case 'b':
+        options->bits_per_sample =
+            static_cast<uint16_t>(std::atoi(value.c_str()));
+        if (options->bits_per_sample % 8 != 0 ||
+            options->bits_per_sample == 0 || options->bits_per_sample > 32) {
+          return false;
+        }
+        break;
+      case 'c':
+        options->channel_number =
+            static_cast<uint16_t>(std::atoi(value.c_str()));
+        if (options->channel_number == 0) {
+          return false;
+        }
+        break;
+      case 'd':
+        if (value == "none") {
+          options->dither = wave::kNoDither;
+        } else if (value == "tpdf") {
+          options->dither = wave::kTPDFDither;
+        } else if (value == "shaped") {
+          options->dither = wave::kNoiseShapedDither;
+        } else {
+          return false;
+        }
+        break;
+      case 'j':
+        options->thread_number =
+            static_cast<size_t>(std::atoi(value.c_str()));
+        break;
+      case 'f':
+        options->block_frame_number = std::strtoull(value.c_str(), nullptr, 10);
+        if (options->block_frame_number == 0) {
+          return false;
+        }
+        break;
+      case 'o':
+        options->output_directory = value;
+        break;
+      default:
+        return false;
+    }
+  }
+  return !options->output_directory.empty() && !options->inputs.empty();
+}
+
+std::string Throughput(const Result& result) {
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(1)
+         << result.byte_number / 1e6 / result.seconds << " MB/s, "
+         << result.duration / result.seconds << "x real time";
+  return stream.str();
+}
+
+}  // namespace
+
+// Convert WAVE files between bit depths, channel layouts and byte orders.
+// Files are converted in parallel, each worker taking the next file left
+// once it is done with the previous one, and reading and writing blocks of
+// a fixed size so that memory doesn't grow with file sizes. Throughput is
+// reported for each file and for the whole batch, file timings include
+// opening and closing both files.
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage();
+    return 2;
+  }
+  std::vector<std::string> paths;
+  for (const auto& input : options.inputs) {
+    if (!ListDirectory(input, &paths)) {
+      paths.push_back(input);
+    }
+  }
+  // outputs are named after their input, inputs from several directories
+  // could overwrite each other
+  std::map<std::string, std::string> output_names;
+  auto duplicate = false;
+  for (const auto& path : paths) {
+    auto inserted = output_names.emplace(FileName(path), path);
+    if (!inserted.second) {
+      std::cerr << path << ": same output name as " << inserted.first->second
+                << std::endl;
+      duplicate = true;
+    }
+  }
+  if (duplicate) {
+    return 2;
+  }
+  if (options.thread_number == 0) {
+    options.thread_number =
+        std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  options.thread_number = std::min(options.thread_number, paths.size());
+
+  std::vector<Result> results(paths.size());
+  std::atomic<size_t> next_path(0);
+  std::mutex output_mutex;
+  auto start = std::chrono::steady_clock::now();
+  {
+    wave::ThreadPool pool(options.thread_number);
+    for (size_t worker = 0; worker < options.thread_number; worker++) {
+      pool.Schedule([&]() {
+        // reused for all the files of the worker
+        std::vector<float> block;
+        std::vector<char> raw_block;
+        for (auto idx = next_path++; idx < paths.size(); idx = next_path++) {
+          const auto& path = paths[idx];
+          auto output_path =
+              options.output_directory + "/" + FileName(path);
+          auto& result = results[idx];
+          auto file_start = std::chrono::steady_clock::now();
+          result.error = Convert(options, path, output_path, &block,
+                                 &raw_block, &result);
+          std::chrono::duration<double> elapsed =
+              std::chrono::steady_clock::now() - file_start;
+          result.seconds = elapsed.count();
+
+          std::lock_guard<std::mutex> lock(output_mutex);
+          if (result.error != wave::kNoError) {
+            std::cerr << path << ": " << ErrorName(result.error)
+                      << std::endl;
+          } else {
+            std::cout << path << ": " << result.frame_number << " frames, "
+                      << Throughput(result) << std::endl;
+          }
+        }
+      });
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  Result total;
+  total.seconds = elapsed.count();
+  size_t failure_number = 0;
+  for (const auto& result : results) {
+    if (result.error != wave::kNoError) {
+      failure_number++;
+      continue;
+    }
+    total.frame_number += result.frame_number;
+    total.byte_number += result.byte_number;
+    total.duration += result.duration;
+  }
+  auto converted_number = paths.size() - failure_number;
+  std::cout << converted_number << " files converted, " << failure_number
+            << " failed, in " << std::fixed << std::setprecision(3)
+            << total.seconds << " s: " << std::setprecision(1)
+            << converted_number / total.seconds << " files per second, "
+            << Throughput(total) << std::endl;
+  return failure_number == 0 ? 0 : 1;
+}
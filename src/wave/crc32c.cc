@@ -0,0 +1,340 @@
+#include "wave/crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define WAVE_CRC32C_SSE42
+#include <immintrin.h>
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define WAVE_CRC32C_ARM
+#include <arm_acle.h>
+#endif
+
+namespace wave {
+namespace internal {
+
+namespace {
+
+// reversed Castagnoli polynomial
+const uint32_t kPolynomial = 0x82f63b78;
+
+// Tables to process 8 bytes at once in software
+struct Tables {
+  Tables() {
+    for (uint32_t idx = 0; idx < 256; idx++) {
+      uint32_t crc = idx;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = crc & 1 ? (crc >> 1) ^ kPolynomial : crc >> 1;
+      }
+      values[0][idx] = crc;
+    }
+    for (uint32_t idx = 0; idx < 256; idx++) {
+      for (int table = 1; table < 8; table++) {
+        values[table][idx] = (values[table - 1][idx] >> 8) ^
+                             values[0][values[table - 1][idx] & 0xff];
+      }
+    }
+  }
+  uint32_t values[8][256];
+};
+
+const Tables& SoftwareTables() {
+  static const Tables tables;
+  return tables;
+}
+
+uint32_t SoftwareCrc(uint32_t crc, const unsigned char* data, size_t size) {
+  auto& table = SoftwareTables().values;
+  while (size >= 8) {
+    uint32_t low, high;
+    memcpy(&low, data, 4);
+    memcpy(&high, data + 4, 4);
+    low ^= crc;
+    crc = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^
+          table[5][(low >> 16) & 0xff] ^ table[4][low >> 24] ^
+          table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff] ^
+          table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(WAVE_CRC32C_SSE42) || defined(WAVE_CRC32C_ARM)
+// The CRC instructions have a latency of several cycles, hardware versions
+// run three independent streams of kLongStride bytes and combine them. The
+// shorter stride keeps most of what is left on three streams as well
+const size_t kLongStride = 8192;
+const size_t kShortStride = 256;
+
+// a * b modulo the polynomial
+uint32_t MultiplyModulo(uint32_t a, uint32_t b) {
+  uint32_t result = 0;
+  for (uint32_t mask = 1u << 31; mask != 0; mask >>= 1) {
+    if (a & mask) {
+      result ^= b;
+    }
+    b = b & 1 ? (b >> 1) ^ kPolynomial : b >> 1;
+  }
+  return result;
+}
+
+// x^exponent modulo the polynomial
+uint32_t PowerModulo(uint64_t exponent) {
+  uint32_t result = 1u << 31;  // x^0
+  uint32_t power = 1u << 30;   // x^1
+  for (; exponent != 0; exponent >>= 1) {
+    if (exponent & 1) {
+      result = MultiplyModulo(result, power);
+    }
+    power = MultiplyModulo(power, power);
+  }
+  return result;
+}
+
+// x^(8 * size) modulo the polynomial, which moves a crc over size zeros
+uint32_t ShiftOperator(size_t size) {
+  return PowerModulo(static_cast<uint64_t>(size) * 8);
+}
+
+// Moving a crc over kStride zeros is linear, it is tabulated for each byte
+// of the crc so that combining streams costs four lookups
+template <size_t kStride>
+struct ShiftTables {
+  ShiftTables() {
+    auto shift = ShiftOperator(kStride);
+    for (uint32_t byte = 0; byte < 4; byte++) {
+      for (uint32_t idx = 0; idx < 256; idx++) {
+        values[byte][idx] = MultiplyModulo(shift, idx << (8 * byte));
+      }
+    }
+  }
+  uint32_t values[4][256];
+};
+
+template <size_t kStride>
+uint32_t StrideShift(uint32_t crc) {
+  static const ShiftTables<kStride> tables;
+  auto& table = tables.values;
+  return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+         table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+#endif  // WAVE_CRC32C_SSE42 || WAVE_CRC32C_ARM
+
+#ifdef WAVE_CRC32C_SSE42
+#define WAVE_CRC32C_TARGET __attribute__((target("sse4.2")))
+#define WAVE_CRC32C_U64(crc, value) \
+  static_cast<uint32_t>(_mm_crc32_u64(crc, value))
+#define WAVE_CRC32C_U8(crc, value) _mm_crc32_u8(crc, value)
+#elif defined(WAVE_CRC32C_ARM)
+#define WAVE_CRC32C_TARGET
+#define WAVE_CRC32C_U64(crc, value) __crc32cd(crc, value)
+#define WAVE_CRC32C_U8(crc, value) __crc32cb(crc, value)
+#endif
+
+#ifdef WAVE_CRC32C_SSE42
+#define WAVE_CRC32C_FOLD_TARGET __attribute__((target("sse4.2,pclmul")))
+#define WAVE_CRC32C_WIDE_TARGET \
+  __attribute__((target("sse4.2,pclmul,avx512f,vpclmulqdq")))
+
+// Constants to move a 16 byte lane over the distance bytes that follow: its
+// first 8 bytes are multiplied by x^(8 * distance + 31) and its last 8 bytes
+// by x^(8 * distance - 33), modulo the polynomial. The 64 bits between the
+// halves and the 33 bits a carry-less product of reflected values is off by
+// make up the difference with x^(8 * distance)
+__m128i FoldConstants(size_t distance) {
+  return _mm_set_epi64x(PowerModulo(8 * distance - 33),
+                        PowerModulo(8 * distance + 31));
+}
+
+// Same constants for each 16 byte lane of a 64 byte register
+WAVE_CRC32C_WIDE_TARGET
+__m512i WideFoldConstants(size_t distance) {
+  int64_t low = PowerModulo(8 * distance + 31);
+  int64_t high = PowerModulo(8 * distance - 33);
+  return _mm512_set_epi64(high, low, high, low, high, low, high, low);
+}
+
+WAVE_CRC32C_FOLD_TARGET
+inline __m128i Fold(__m128i lanes, __m128i constants, __m128i data) {
+  return _mm_xor_si128(
+      _mm_xor_si128(_mm_clmulepi64_si128(lanes, constants, 0x00),
+                    _mm_clmulepi64_si128(lanes, constants, 0x11)),
+      data);
+}
+
+// Fold four consecutive lanes into the last one and take its crc
+WAVE_CRC32C_FOLD_TARGET
+uint32_t Reduce(__m128i lane0, __m128i lane1, __m128i lane2, __m128i lane3) {
+  static const __m128i kFold16 = FoldConstants(16);
+  lane1 = Fold(lane0, kFold16, lane1);
+  lane2 = Fold(lane1, kFold16, lane2);
+  lane3 = Fold(lane2, kFold16, lane3);
+  auto crc =
+      WAVE_CRC32C_U64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(lane3)));
+  return WAVE_CRC32C_U64(
+      crc, static_cast<uint64_t>(_mm_extract_epi64(lane3, 1)));
+}
+
+// The crc32 instruction is bound by its latency, carry-less multiplications
+// fold the data faster: four 16 byte lanes are each folded over the 64 bytes
+// that follow, then into one another, and the last lane is reduced with the
+// crc32 instruction. Blocks of 64 bytes are consumed
+WAVE_CRC32C_FOLD_TARGET
+uint32_t FoldedCrc(uint32_t crc, const unsigned char** data, size_t* size) {
+  static const __m128i kFold64 = FoldConstants(64);
+  if (*size < 128) {
+    return crc;
+  }
+  auto bytes = reinterpret_cast<const __m128i*>(*data);
+  auto lane0 = _mm_xor_si128(_mm_loadu_si128(bytes),
+                             _mm_cvtsi32_si128(static_cast<int>(crc)));
+  auto lane1 = _mm_loadu_si128(bytes + 1);
+  auto lane2 = _mm_loadu_si128(bytes + 2);
+  auto lane3 = _mm_loadu_si128(bytes + 3);
+  auto block_number = *size / 64;
+  for (size_t block = 1; block < block_number; block++) {
+    bytes += 4;
+    lane0 = Fold(lane0, kFold64, _mm_loadu_si128(bytes));
+    lane1 = Fold(lane1, kFold64, _mm_loadu_si128(bytes + 1));
+    lane2 = Fold(lane2, kFold64, _mm_loadu_si128(bytes + 2));
+    lane3 = Fold(lane3, kFold64, _mm_loadu_si128(bytes + 3));
+  }
+  *data += block_number * 64;
+  *size -= block_number * 64;
+  return Reduce(lane0, lane1, lane2, lane3);
+}
+
+WAVE_CRC32C_WIDE_TARGET
+inline __m512i WideFold(__m512i lanes, __m512i constants, __m512i data) {
+  // 0x96 is a three way xor
+  return _mm512_ternarylogic_epi64(
+      _mm512_clmulepi64_epi128(lanes, constants, 0x00),
+      _mm512_clmulepi64_epi128(lanes, constants, 0x11), data, 0x96);
+}
+
+// Same as FoldedCrc with four lanes in each of four 64 byte registers,
+// consuming blocks of 256 bytes
+WAVE_CRC32C_WIDE_TARGET
+uint32_t WideFoldedCrc(uint32_t crc, const unsigned char** data,
+                       size_t* size) {
+  static const __m512i kFold256 = WideFoldConstants(256);
+  static const __m512i kFold64 = WideFoldConstants(64);
+  if (*size < 512) {
+    return crc;
+  }
+  auto bytes = *data;
+  auto lanes0 = _mm512_xor_si512(
+      _mm512_loadu_si512(bytes),
+      _mm512_castsi128_si512(_mm_cvtsi32_si128(static_cast<int>(crc))));
+  auto lanes1 = _mm512_loadu_si512(bytes + 64);
+  auto lanes2 = _mm512_loadu_si512(bytes + 128);
+  auto lanes3 = _mm512_loadu_si512(bytes + 192);
+  auto block_number = *size / 256;
+  for (size_t block = 1; block < block_number; block++) {
+    bytes += 256;
+    lanes0 = WideFold(lanes0, kFold256, _mm512_loadu_si512(bytes));
+    lanes1 = WideFold(lanes1, kFold256, _mm512_loadu_si512(bytes + 64));
+    lanes2 = WideFold(lanes2, kFold256, _mm512_loadu_si512(bytes + 128));
+    lanes3 = WideFold(lanes3, kFold256, _mm512_loadu_si512(bytes + 192));
+  }
+  lanes1 = WideFold(lanes0, kFold64, lanes1);
+  lanes2 = WideFold(lanes1, kFold64, lanes2);
+  lanes3 = WideFold(lanes2, kFold64, lanes3);
+  *data += block_number * 256;
+  *size -= block_number * 256;
+  __m128i lanes[4];
+  _mm512_storeu_si512(lanes, lanes3);
+  return Reduce(lanes[0], lanes[1], lanes[2], lanes[3]);
+}
+
+bool HasCarrylessMultiply() {
+  static const bool has_pclmul = __builtin_cpu_supports("pclmul");
+  return has_pclmul;
+}
+
+bool HasWideCarrylessMultiply() {
+  static const bool has_vpclmulqdq = __builtin_cpu_supports("avx512f") &&
+                                     __builtin_cpu_supports("vpclmulqdq");
+  return has_vpclmulqdq;
+}
+#endif  // WAVE_CRC32C_SSE42
+
+#ifdef WAVE_CRC32C_TARGET
+template <size_t kStride>
+WAVE_CRC32C_TARGET uint32_t InterleavedCrc(uint32_t crc,
+                                           const unsigned char** data,
+                                           size_t* size) {
+  uint64_t value0, value1, value2;
+  while (*size >= 3 * kStride) {
+    uint32_t crc1 = 0;
+    uint32_t crc2 = 0;
+    auto bytes = *data;
+    for (size_t offset = 0; offset < kStride; offset += 8) {
+      memcpy(&value0, bytes + offset, 8);
+      memcpy(&value1, bytes + kStride + offset, 8);
+      memcpy(&value2, bytes + 2 * kStride + offset, 8);
+      crc = WAVE_CRC32C_U64(crc, value0);
+      crc1 = WAVE_CRC32C_U64(crc1, value1);
+      crc2 = WAVE_CRC32C_U64(crc2, value2);
+    }
+    crc = StrideShift<kStride>(StrideShift<kStride>(crc) ^ crc1) ^ crc2;
+    *data += 3 * kStride;
+    *size -= 3 * kStride;
+  }
+  return crc;
+}
+
+WAVE_CRC32C_TARGET
+uint32_t HardwareCrc(uint32_t crc, const unsigned char* data, size_t size) {
+#ifdef WAVE_CRC32C_SSE42
+  if (HasWideCarrylessMultiply()) {
+    crc = WideFoldedCrc(crc, &data, &size);
+  }
+  if (HasCarrylessMultiply()) {
+    crc = FoldedCrc(crc, &data, &size);
+  }
+#endif  // WAVE_CRC32C_SSE42
+  crc = InterleavedCrc<kLongStride>(crc, &data, &size);
+  crc = InterleavedCrc<kShortStride>(crc, &data, &size);
+  uint64_t value0;
+  while (size >= 8) {
+    memcpy(&value0, data, 8);
+    crc = WAVE_CRC32C_U64(crc, value0);
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = WAVE_CRC32C_U8(crc, *data++);
+  }
+  return crc;
+}
+
+bool HasHardwareCrc() {
+#ifdef WAVE_CRC32C_SSE42
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+#else
+  return true;
+#endif  // WAVE_CRC32C_SSE42
+}
+#endif  // WAVE_CRC32C_TARGET
+
+}  // namespace
+
+uint32_t Crc32c(uint32_t crc, const char* data, size_t size) {
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+#ifdef WAVE_CRC32C_TARGET
+  if (HasHardwareCrc()) {
+    return ~HardwareCrc(~crc, bytes, size);
+  }
+#endif  // WAVE_CRC32C_TARGET
+  return ~SoftwareCrc(~crc, bytes, size);
+}
+
+}  // namespace internal
+}  // namespace wave
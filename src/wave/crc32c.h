@@ -0,0 +1,21 @@
+#ifndef WAVE_WAVE_CRC32C_H_
+#define WAVE_WAVE_CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wave {
+namespace internal {
+
+/**
+ * @brief Extend the CRC32C (Castagnoli) checksum crc with size bytes of data.
+ * The checksum of nothing is 0. Uses carry-less multiplications and the CRC
+ * instructions of SSE4.2 on x86, the CRC instructions of ARMv8, or a table
+ * based implementation when the CPU has none of them.
+ */
+uint32_t Crc32c(uint32_t crc, const char* data, size_t size);
+
+}  // namespace internal
+}  // namespace wave
+
+#endif  // WAVE_WAVE_CRC32C_H_
@@ -0,0 +1,161 @@
+#include "wave/crop_sampler.h"
+
+#include <algorithm>
+#include <future>
+#include <random>
+
+#include "wave/file_pool.h"
+#include "wave/thread_pool.h"
+
+namespace wave {
+
+class CropSampler::Impl {
+ public:
+  Impl(size_t thread_number, size_t max_open_file_number)
+      : pool(std::max<size_t>(thread_number, 1)),
+        files(max_open_file_number),
+        sample_rate(0),
+        channel_number(0),
+        crop_frame_number(0) {}
+
+  // Read crop into output, frame_index is drawn from random
+  Error ReadCrop(uint64_t random, Crop* crop, std::vector<float>* frames,
+                 float* output) {
+    const auto& path = paths[crop->file_index];
+    Metadata metadata;
+    auto error = files.Probe(path, &metadata);
+    if (error != kNoError) {
+      return error;
+    }
+    if (metadata.sample_rate != sample_rate ||
+        metadata.channel_number != channel_number ||
+        metadata.frame_number < crop_frame_number) {
+      return kInvalidFormat;
+    }
+    crop->frame_index =
+        random % (metadata.frame_number - crop_frame_number + 1);
+    if (channel_number == 1) {
+      return files.Read(path, crop->frame_index, crop_frame_number, output);
+    }
+    // frames are interleaved, channels of the crop follow each other
+    frames->resize(crop_frame_number * channel_number);
+    error = files.Read(path, crop->frame_index, crop_frame_number,
+                       frames->data());
+    if (error != kNoError) {
+      return error;
+    }
+    for (uint16_t channel = 0; channel < channel_number; channel++) {
+      auto samples = frames->data() + channel;
+      auto channel_output = output + channel * crop_frame_number;
+      for (uint64_t frame = 0; frame < crop_frame_number; frame++) {
+        channel_output[frame] = samples[frame * channel_number];
+      }
+    }
+    return kNoError;
+  }
+
+  ThreadPool pool;
+  FilePool files;
+  std::vector<std::string> paths;
+  uint32_t sample_rate;
+  uint16_t channel_number;
+  uint64_t crop_frame_number;
+  std::mt19937_64 random;
+
+  // interleaved frames of the crop read by each task
+  std::vector<std::vector<float>> frames;
+  // origin of the crops of the current batch
+  std::vector<Crop> crops;
+};
+
+CropSampler::CropSampler(size_t thread_number, size_t max_open_file_number)
+    : impl_(new Impl(thread_number, max_open_file_number)) {}
+
+CropSampler::~CropSampler() = default;
+
+Error CropSampler::Open(const std::vector<std::string>& paths,
+                        uint32_t sample_rate, uint16_t channel_number,
+                        uint64_t crop_frame_number) {
+  if (paths.empty() || channel_number == 0 || crop_frame_number == 0) {
+    return kInvalidFormat;
+  }
+  impl_->files.Clear();
+  impl_->paths = paths;
+  impl_->sample_rate = sample_rate;
+  impl_->channel_number = channel_number;
+  impl_->crop_frame_number = crop_frame_number;
+  set_seed(0);
+  return kNoError;
+}
+
+void CropSampler::set_seed(uint64_t seed) { impl_->random.seed(seed); }
+
+Error CropSampler::Sample(size_t batch_size, std::vector<float>* output,
+                          std::vector<Crop>* crops) {
+  if (impl_->paths.empty()) {
+    return kNotOpen;
+  }
+  output->resize(batch_size * channel_number() * crop_frame_number());
+  return Sample(batch_size, output->data(), crops);
+}
+
+Error CropSampler::Sample(size_t batch_size, float* output,
+                          std::vector<Crop>* crops) {
+  if (impl_->paths.empty()) {
+    return kNotOpen;
+  }
+  // drawn here in crop order so that crops don't depend on the threads
+  auto& batch_crops = impl_->crops;
+  batch_crops.resize(batch_size);
+  std::vector<uint64_t> randoms(batch_size);
+  for (size_t crop = 0; crop < batch_size; crop++) {
+    batch_crops[crop].file_index = impl_->random() % impl_->paths.size();
+    randoms[crop] = impl_->random();
+  }
+
+  // a task for each thread, reading its share of the crops in turn
+  auto task_number = std::min(impl_->pool.thread_number(), batch_size);
+  impl_->frames.resize(task_number);
+  auto crop_size = channel_number() * crop_frame_number();
+  std::vector<std::future<Error>> results;
+  for (size_t task = 0; task < task_number; task++) {
+    auto promise = std::make_shared<std::promise<Error>>();
+    results.push_back(promise->get_future());
+    auto begin = batch_size * task / task_number;
+    auto end = batch_size * (task + 1) / task_number;
+    impl_->pool.Schedule([this, promise, task, begin, end, &randoms, output,
+                          crop_size]() {
+      auto error = kNoError;
+      for (auto crop = begin; crop < end && error == kNoError; crop++) {
+        error = impl_->ReadCrop(randoms[crop], &impl_->crops[crop],
+                                &impl_->frames[task],
+                                output + crop * crop_size);
+      }
+      promise->set_value(error);
+    });
+  }
+  // the first error in crop order
+  auto error = kNoError;
+  for (auto& result : results) {
+    auto task_error = result.get();
+    if (error == kNoError) {
+      error = task_error;
+    }
+  }
+  if (error == kNoError && crops != nullptr) {
+    *crops = batch_crops;
+  }
+  return error;
+}
+
+uint32_t CropSampler::sample_rate() const { return impl_->sample_rate; }
+
+uint16_t CropSampler::channel_number() const {
+  return impl_->channel_number;
+}
+
+uint64_t CropSampler::crop_frame_number() const {
+  return impl_->crop_frame_number;
+}
+
+}  // namespace wave
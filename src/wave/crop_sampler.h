@@ -0,0 +1,80 @@
+#ifndef WAVE_WAVE_CROP_SAMPLER_H_
+#define WAVE_WAVE_CROP_SAMPLER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+
+namespace wave {
+
+/**
+ * @brief Origin of a crop drawn by CropSampler
+ */
+struct Crop {
+  // index of the file in the paths given to CropSampler::Open
+  size_t file_index;
+  uint64_t frame_index;
+};
+
+/**
+ * @brief Draw batches of random crops from a list of files, as training
+ * loaders do. A batch is a single buffer of batch_size x channel_number x
+ * crop_frame_number samples in row-major order: crops, then their channels,
+ * then their frames. Crops are read in parallel and files stay open from
+ * one batch to the next, see FilePool.
+ */
+class CropSampler {
+ public:
+  /**
+   * @brief thread_number threads read the crops of a batch, with at most
+   * max_open_file_number files open.
+   */
+  explicit CropSampler(size_t thread_number = 4,
+                       size_t max_open_file_number = 128);
+  ~CropSampler();
+
+  /**
+   * @brief Draw crops of crop_frame_number frames from the files at paths,
+   * which must have the given sample rate and channel number.
+   * @note: files are only opened by the batches drawing crops from them.
+   * Sample returns kInvalidFormat when it draws a file of another format or
+   * shorter than a crop.
+   */
+  Error Open(const std::vector<std::string>& paths, uint32_t sample_rate,
+             uint16_t channel_number, uint64_t crop_frame_number);
+
+  /**
+   * @brief Restart the random crops. The same seed gives the same crops,
+   * whatever the number of threads. The seed is 0 by default.
+   */
+  void set_seed(uint64_t seed);
+
+  /**
+   * @brief Draw a batch of batch_size crops. crops gets the origin of each
+   * of them when given.
+   */
+  Error Sample(size_t batch_size, std::vector<float>* output,
+               std::vector<Crop>* crops = nullptr);
+
+  /**
+   * @brief Draw a batch into memory owned by the caller (e.g. a tensor),
+   * which must have room for batch_size crops.
+   */
+  Error Sample(size_t batch_size, float* output,
+               std::vector<Crop>* crops = nullptr);
+
+  uint32_t sample_rate() const;
+  uint16_t channel_number() const;
+  uint64_t crop_frame_number() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_CROP_SAMPLER_H_
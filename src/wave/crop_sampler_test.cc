@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include "wave/crop_sampler.h"
+#include "wave/test_files.h"
+
+const std::string gResourcePath(TEST_RESOURCES_PATH);
+
+TEST(CropSampler, Sample) {
+  using namespace wave;
+  // stereo files of different lengths and content
+  std::vector<std::string> paths;
+  std::vector<std::vector<float>> contents;
+  for (size_t idx = 0; idx < 5; idx++) {
+    paths.push_back(gResourcePath + "/output-crops-" + std::to_string(idx) +
+                    ".wav");
+    contents.push_back(TestRamp((10000 + idx * 3000) * 2, idx));
+    ASSERT_EQ(WriteTestFile(paths.back(), 2, &contents.back()), kNoError);
+  }
+
+  const uint64_t kCropFrameNumber = 4410;
+  const size_t kBatchSize = 16;
+  CropSampler sampler(3, 2);
+  std::vector<float> batch;
+  ASSERT_EQ(sampler.Sample(kBatchSize, &batch), kNotOpen);
+  ASSERT_EQ(sampler.Open(paths, 44100, 2, kCropFrameNumber), kNoError);
+
+  std::vector<Crop> crops;
+  ASSERT_EQ(sampler.Sample(kBatchSize, &batch, &crops), kNoError);
+  ASSERT_EQ(batch.size(), kBatchSize * 2 * kCropFrameNumber);
+  ASSERT_EQ(crops.size(), kBatchSize);
+  for (size_t crop = 0; crop < kBatchSize; crop++) {
+    const auto& content = contents[crops[crop].file_index];
+    ASSERT_LE((crops[crop].frame_index + kCropFrameNumber) * 2,
+              content.size());
+    // crop, channel, frame
+    for (size_t channel = 0; channel < 2; channel++) {
+      for (uint64_t frame = 0; frame < kCropFrameNumber; frame++) {
+        ASSERT_EQ(batch[(crop * 2 + channel) * kCropFrameNumber + frame],
+                  content[(crops[crop].frame_index + frame) * 2 + channel]);
+      }
+    }
+  }
+
+  // same seed, same crops, whatever the number of threads
+  std::vector<Crop> other_crops;
+  std::vector<float> other_batch;
+  CropSampler other_sampler(1);
+  ASSERT_EQ(other_sampler.Open(paths, 44100, 2, kCropFrameNumber), kNoError);
+  ASSERT_EQ(other_sampler.Sample(kBatchSize, &other_batch, &other_crops),
+            kNoError);
+  ASSERT_EQ(other_batch, batch);
+  other_sampler.set_seed(42);
+  ASSERT_EQ(other_sampler.Sample(kBatchSize, &other_batch, &other_crops),
+            kNoError);
+  ASSERT_NE(other_batch, batch);
+  sampler.set_seed(42);
+  ASSERT_EQ(sampler.Sample(kBatchSize, &batch), kNoError);
+  ASSERT_EQ(other_batch, batch);
+}
+
+TEST(CropSampler, Errors) {
+  using namespace wave;
+  std::vector<std::string> paths = {gResourcePath + "/output-crops.wav"};
+  auto content = TestRamp(10000 * 2, 0);
+  ASSERT_EQ(WriteTestFile(paths[0], 2, &content), kNoError);
+  CropSampler sampler;
+  std::vector<float> batch;
+  ASSERT_EQ(sampler.Open({}, 44100, 2, 100), kInvalidFormat);
+  // format of the files
+  ASSERT_EQ(sampler.Open(paths, 48000, 2, 100), kNoError);
+  ASSERT_EQ(sampler.Sample(4, &batch), kInvalidFormat);
+  ASSERT_EQ(sampler.Open(paths, 44100, 1, 100), kNoError);
+  ASSERT_EQ(sampler.Sample(4, &batch), kInvalidFormat);
+  // crops longer than the file
+  ASSERT_EQ(sampler.Open(paths, 44100, 2, 10001), kNoError);
+  ASSERT_EQ(sampler.Sample(4, &batch), kInvalidFormat);
+  ASSERT_EQ(sampler.Open(paths, 44100, 2, 10000), kNoError);
+  ASSERT_EQ(sampler.Sample(4, &batch), kNoError);
+  ASSERT_EQ(sampler.Open({gResourcePath + "/missing.wav"}, 44100, 2, 100),
+            kNoError);
+  ASSERT_EQ(sampler.Sample(4, &batch), kFailedToOpen);
+}
@@ -0,0 +1,262 @@
+#include "wave/edit.h"
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "wave/header.h"
+#include "wave/header/wave_header.h"
+#include "wave/io/file_copy.h"
+
+namespace wave {
+
+namespace {
+
+// A wave file opened to copy its samples
+class Source {
+ public:
+  Source()
+      : file_(nullptr),
+        big_endian_(false),
+        format_(),
+        data_offset_(0),
+        data_size_(0) {}
+  ~Source() { Close(); }
+
+  Error Open(const std::string& path) {
+    file_ = fopen(path.c_str(), "rb");
+    if (file_ == nullptr) {
+      return kFailedToOpen;
+    }
+    ChunkWalker walker;
+    walker.Open([this](uint64_t position, char* data, uint64_t size) {
+      return ReadFile(file_, position, data, size);
+    }, FileSize(file_));
+    Header data;
+    auto error = walker.FindFormat(&format_, &data);
+    if (error != kNoError) {
+      return error;
+    }
+    big_endian_ = walker.big_endian();
+    data_offset_ = data.position() + Header::kSize;
+    data_size_ = data.content_size();
+
+    // same formats as File
+    auto bits_per_sample = format_.bits_per_sample;
+    if (format_.audio_format != 1 || format_.num_channel == 0 ||
+        (bits_per_sample != 8 && bits_per_sample != 16 &&
+         bits_per_sample != 24 && bits_per_sample != 32)) {
+      return kInvalidFormat;
+    }
+    return kNoError;
+  }
+
+  void Close() {
+    if (file_ != nullptr) {
+      fclose(file_);
+      file_ = nullptr;
+    }
+  }
+
+  FILE* file() const { return file_; }
+  // samples are copied as they are, in the byte order of the source
+  bool big_endian() const { return big_endian_; }
+  const FMTHeader& format() const { return format_; }
+  uint64_t data_offset() const { return data_offset_; }
+  uint64_t frame_size() const {
+    return format_.num_channel * (format_.bits_per_sample / 8);
+  }
+  uint64_t frame_number() const { return data_size_ / frame_size(); }
+
+ private:
+  FILE* file_;
+  bool big_endian_;
+  FMTHeader format_;
+  uint64_t data_offset_;
+  uint64_t data_size_;
+};
+
+bool SameFormat(const FMTHeader& lhs, const FMTHeader& rhs) {
+  return lhs.num_channel == rhs.num_channel &&
+         lhs.sample_rate == rhs.sample_rate &&
+         lhs.bits_per_sample == rhs.bits_per_sample;
+}
+
+// Whether one of outputs is one of inputs, which opening it would truncate
+bool OverwritesInput(const std::vector<std::string>& inputs,
+                     const std::vector<std::string>& outputs) {
+  for (auto& output : outputs) {
+    for (auto& input : inputs) {
+      if (SameFile(input, output)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// A wave file written from the samples of sources
+class Sink {
+ public:
+  Sink() : file_(nullptr), data_size_(0) {}
+  ~Sink() {
+    if (file_ != nullptr) {
+      fclose(file_);
+    }
+  }
+
+  // Headers are written first, data_size has to be known
+  Error Open(const std::string& path, const FMTHeader& format,
+             bool big_endian, uint64_t data_size) {
+    // sizes are stored on 32 bits
+    if (sizeof(WAVEHeader) + data_size + 1 >
+        std::numeric_limits<uint32_t>::max()) {
+      return kInvalidFormat;
+    }
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+      return kFailedToOpen;
+    }
+    data_size_ = data_size;
+
+    auto header = MakeWAVEHeader();
+    header.fmt.num_channel = format.num_channel;
+    header.fmt.sample_rate = format.sample_rate;
+    header.fmt.bits_per_sample = format.bits_per_sample;
+    header.fmt.byte_per_block =
+        format.num_channel * (format.bits_per_sample / 8);
+    header.fmt.byte_rate = format.sample_rate * header.fmt.byte_per_block;
+    header.data.sub_chunk_2_size = static_cast<uint32_t>(data_size);
+    // data is padded to an even size
+    header.riff.chunk_size = static_cast<uint32_t>(
+        sizeof(WAVEHeader) - Header::kSize + data_size + (data_size & 1));
+    if (big_endian) {
+      strncpy(header.riff.chunk_id, "RIFX", 4);
+    }
+    ConvertByteOrder(big_endian, &header);
+    if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+      return kWriteError;
+    }
+    return kNoError;
+  }
+
+  Error Copy(const Source& source, uint64_t first_frame,
+             uint64_t frame_number) {
+    auto frame_size = source.frame_size();
+    if (!CopyFileRange(source.file(),
+                       source.data_offset() + first_frame * frame_size,
+                       file_, frame_number * frame_size)) {
+      return kWriteError;
+    }
+    return kNoError;
+  }
+
+  Error Close() {
+    char padding = 0;
+    auto error = kNoError;
+    if ((data_size_ & 1) && fwrite(&padding, 1, 1, file_) != 1) {
+      error = kWriteError;
+    }
+    if (fclose(file_) != 0) {
+      error = kWriteError;
+    }
+    file_ = nullptr;
+    return error;
+  }
+
+ private:
+  FILE* file_;
+  uint64_t data_size_;
+};
+
+}  // namespace
+
+Error Concat(const std::vector<std::string>& inputs,
+             const std::string& output) {
+  if (inputs.empty()) {
+    return kInvalidFormat;
+  }
+  // check the formats first, inputs are only opened one at a time
+  FMTHeader format = {};
+  bool big_endian = false;
+  uint64_t data_size = 0;
+  for (size_t idx = 0; idx < inputs.size(); idx++) {
+    Source source;
+    auto error = source.Open(inputs[idx]);
+    if (error != kNoError) {
+      return error;
+    }
+    if (idx == 0) {
+      format = source.format();
+      big_endian = source.big_endian();
+    } else if (!SameFormat(format, source.format()) ||
+               big_endian != source.big_endian()) {
+      return kInvalidFormat;
+    }
+    data_size += source.frame_number() * source.frame_size();
+  }
+  if (OverwritesInput(inputs, {output})) {
+    return kFailedToOpen;
+  }
+
+  Sink sink;
+  auto error = sink.Open(output, format, big_endian, data_size);
+  if (error != kNoError) {
+    return error;
+  }
+  for (auto& input : inputs) {
+    Source source;
+    error = source.Open(input);
+    if (error == kNoError) {
+      error = sink.Copy(source, 0, source.frame_number());
+    }
+    if (error != kNoError) {
+      return error;
+    }
+  }
+  return sink.Close();
+}
+
+Error Split(const std::string& input,
+            const std::vector<uint64_t>& frame_boundaries,
+            const std::vector<std::string>& outputs) {
+  Source source;
+  auto error = source.Open(input);
+  if (error != kNoError) {
+    return error;
+  }
+  if (outputs.size() != frame_boundaries.size() + 1) {
+    return kInvalidSeek;
+  }
+  for (size_t idx = 0; idx < frame_boundaries.size(); idx++) {
+    if (frame_boundaries[idx] > source.frame_number() ||
+        (idx > 0 && frame_boundaries[idx] < frame_boundaries[idx - 1])) {
+      return kInvalidSeek;
+    }
+  }
+  if (OverwritesInput({input}, outputs)) {
+    return kFailedToOpen;
+  }
+
+  for (size_t idx = 0; idx < outputs.size(); idx++) {
+    uint64_t first_frame = idx == 0 ? 0 : frame_boundaries[idx - 1];
+    uint64_t end_frame = idx < frame_boundaries.size() ? frame_boundaries[idx]
+                                                       : source.frame_number();
+    auto frame_number = end_frame - first_frame;
+    Sink sink;
+    error = sink.Open(outputs[idx], source.format(), source.big_endian(),
+                      frame_number * source.frame_size());
+    if (error == kNoError) {
+      error = sink.Copy(source, first_frame, frame_number);
+    }
+    if (error == kNoError) {
+      error = sink.Close();
+    }
+    if (error != kNoError) {
+      return error;
+    }
+  }
+  return kNoError;
+}
+
+}  // namespace wave
@@ -0,0 +1,37 @@
+#ifndef WAVE_WAVE_EDIT_H_
+#define WAVE_WAVE_EDIT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+
+namespace wave {
+
+/**
+ * @brief Write the samples of all the inputs, one after the other, to
+ * output. Samples are copied as they are, only the headers are written.
+ * @note: inputs must share the same format or kInvalidFormat is returned.
+ * kFailedToOpen is returned, before anything is written, if output is one of
+ * the inputs. Chunks other than fmt and data are not copied.
+ */
+Error Concat(const std::vector<std::string>& inputs,
+             const std::string& output);
+
+/**
+ * @brief Write the samples of input to outputs, cut at the given frames.
+ * outputs[0] receives the frames before frame_boundaries[0], the last output
+ * the frames after the last boundary. Samples are copied as they are, only
+ * the headers are written.
+ * @note: boundaries must be increasing, not exceed the frame number of input
+ * and be one less than outputs or kInvalidSeek is returned. kFailedToOpen is
+ * returned, before anything is written, if one of the outputs is input.
+ */
+Error Split(const std::string& input,
+            const std::vector<uint64_t>& frame_boundaries,
+            const std::vector<std::string>& outputs);
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_EDIT_H_
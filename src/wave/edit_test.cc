@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include "wave/edit.h"
+#include "wave/file.h"
+#include "wave/test_files.h"
+
+const std::string gResourcePath(TEST_RESOURCES_PATH);
+
+TEST(Edit, SplitConcat) {
+  using namespace wave;
+  File file;
+  ASSERT_EQ(file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn),
+            kNoError);
+  std::vector<float> content;
+  ASSERT_EQ(file.Read(&content), kNoError);
+
+  std::vector<uint64_t> boundaries = {1000, 100001, 100001};
+  std::vector<std::string> outputs;
+  for (int idx = 0; idx < 4; idx++) {
+    outputs.push_back(gResourcePath + "/output-split-" + std::to_string(idx) +
+                      ".wav");
+  }
+  ASSERT_EQ(Split(gResourcePath + "/Untitled3.wav", boundaries, outputs),
+            kNoError);
+
+  // each part holds its frames
+  auto channel_number = file.channel_number();
+  uint64_t first_frame = 0;
+  for (size_t idx = 0; idx < outputs.size(); idx++) {
+    uint64_t end_frame =
+        idx < boundaries.size() ? boundaries[idx] : file.frame_number();
+    File part;
+    ASSERT_EQ(part.Open(outputs[idx], OpenMode::kIn), kNoError);
+    ASSERT_EQ(part.sample_rate(), file.sample_rate());
+    ASSERT_EQ(part.channel_number(), channel_number);
+    ASSERT_EQ(part.frame_number(), end_frame - first_frame);
+    std::vector<float> part_content;
+    ASSERT_EQ(part.Read(&part_content), kNoError);
+    ASSERT_TRUE(std::equal(part_content.begin(), part_content.end(),
+                           content.begin() + first_frame * channel_number));
+    first_frame = end_frame;
+  }
+
+  // and joining them gives back the original
+  auto path = gResourcePath + "/output-concat.wav";
+  ASSERT_EQ(Concat(outputs, path), kNoError);
+  File joined;
+  ASSERT_EQ(joined.Open(path, OpenMode::kIn), kNoError);
+  std::vector<float> joined_content;
+  ASSERT_EQ(joined.Read(&joined_content), kNoError);
+  ASSERT_EQ(content, joined_content);
+}
+
+TEST(Edit, BigEndian) {
+  using namespace wave;
+  auto rifx = gResourcePath + "/output-rifx.wav";
+  std::vector<float> content(4000);
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    content[idx] = static_cast<float>(idx % 100) / 100.f;
+  }
+  {
+    File file;
+    ASSERT_EQ(file.Open(rifx, OpenMode::kOut), kNoError);
+    file.set_big_endian(true);
+    file.set_channel_number(2);
+    ASSERT_EQ(file.Write(content), kNoError);
+  }
+  // parts keep the byte order of the input
+  std::vector<std::string> outputs = {gResourcePath + "/output-split-0.wav",
+                                      gResourcePath + "/output-split-1.wav"};
+  ASSERT_EQ(Split(rifx, {500}, outputs), kNoError);
+  auto path = gResourcePath + "/output-concat.wav";
+  ASSERT_EQ(Concat(outputs, path), kNoError);
+  File joined;
+  ASSERT_EQ(joined.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_TRUE(joined.big_endian());
+  std::vector<float> joined_content;
+  ASSERT_EQ(joined.Read(&joined_content), kNoError);
+  ASSERT_EQ(joined_content.size(), content.size());
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    ASSERT_NEAR(joined_content[idx], content[idx], 1e-4);
+  }
+
+  // samples are copied as they are, byte orders can't be mixed
+  ASSERT_EQ(Concat({rifx, gResourcePath + "/Untitled3.wav"}, path),
+            kInvalidFormat);
+}
+
+TEST(Edit, Errors) {
+  using namespace wave;
+  auto input = gResourcePath + "/Untitled3.wav";
+  auto output = gResourcePath + "/output-edit.wav";
+  ASSERT_EQ(Concat({}, output), kInvalidFormat);
+  ASSERT_EQ(Concat({input, "incorrect_path"}, output), kFailedToOpen);
+  ASSERT_EQ(Concat({input, gResourcePath + "/8kulaw.wav"}, output),
+            kInvalidFormat);
+
+  ASSERT_EQ(Split(input, {10}, {output}), kInvalidSeek);
+  ASSERT_EQ(Split(input, {10, 5}, {output, output, output}), kInvalidSeek);
+  ASSERT_EQ(Split(input, {1ull << 40}, {output, output}), kInvalidSeek);
+}
+
+TEST(Edit, OverwriteInput) {
+  using namespace wave;
+  std::vector<std::string> inputs;
+  std::vector<std::vector<float>> contents;
+  for (size_t idx = 0; idx < 2; idx++) {
+    inputs.push_back(gResourcePath + "/output-input-" + std::to_string(idx) +
+                     ".wav");
+    contents.push_back(TestRamp(2000, idx));
+    ASSERT_EQ(WriteTestFile(inputs[idx], 2, &contents[idx]), kNoError);
+  }
+
+  // outputs are compared to inputs as files, not as paths
+  auto same_input = gResourcePath + "/./output-input-0.wav";
+  ASSERT_EQ(Concat(inputs, same_input), kFailedToOpen);
+  ASSERT_EQ(Split(inputs[1], {500},
+                  {gResourcePath + "/output-split.wav",
+                   gResourcePath + "/./output-input-1.wav"}),
+            kFailedToOpen);
+
+  // and left as they were
+  for (size_t idx = 0; idx < inputs.size(); idx++) {
+    File file;
+    ASSERT_EQ(file.Open(inputs[idx], OpenMode::kIn), kNoError);
+    std::vector<float> content;
+    ASSERT_EQ(file.Read(&content), kNoError);
+    ASSERT_EQ(content, contents[idx]);
+  }
+}
@@ -10,7 +10,9 @@ enum Error {
   kInvalidFormat,
   kWriteError,
   kReadError,
-  kInvalidSeek
+  kInvalidSeek,
+  kChunkNotFound,
+  kInvalidChecksum
 };
 
 }  // namespace wave
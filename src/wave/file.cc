@@ -1,23 +1,46 @@
 #include "wave/file.h"
 
-#include <fstream>
+#include <algorithm>
 #include <cstring>
 #include <limits>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
 #include <iostream>
 
-#include "wave/header_list.h"
+#include "wave/byte_order.h"
+#include "wave/chunk.h"
+#include "wave/codec.h"
+#include "wave/crc32c.h"
+#include "wave/header.h"
+#include "wave/io_backend.h"
+#include "wave/stream/file_stream.h"
+#ifdef WAVE_HAVE_DIRECT_IO
+#include "wave/stream/direct_file_stream.h"
+#endif  // WAVE_HAVE_DIRECT_IO
+#include "wave/stream/memory_stream.h"
+#include "wave/stream/vector_stream.h"
+#include "wave/thread_pool.h"
 #include "wave/header/riff_header.h"
 #include "wave/header/fmt_header.h"
 #include "wave/header/data_header.h"
 #include "wave/header/wave_header.h"
 
-#define INT24_MAX 8388607
-
 namespace wave {
 
 namespace internal {
 void NoEncrypt(char* data, size_t size) {}
 void NoDecrypt(char* data, size_t size) {}
+
+// number of bytes decoded or encoded at once by Read and Write
+const size_t kBlockSize = 1 << 16;
+// chunk holding the CRC32C of the samples
+const char kChecksumChunkId[] = "crc ";
+
+bool IsSupportedBitsPerSample(uint16_t bits_per_sample) {
+  return bits_per_sample == 8 || bits_per_sample == 16 ||
+         bits_per_sample == 24 || bits_per_sample == 32;
+}
 }  // namespace internal
   
 enum Format {
@@ -30,13 +53,46 @@ enum Format {
 
 class File::Impl {
  public:
+  Impl()
+      : stream(nullptr),
+        mode(kIn),
+        data_offset_(0),
+        chunks_listed(false),
+        backend(nullptr),
+        backend_handle(-1),
+        expected_frame_number(0),
+        reserved(false),
+        presized(false),
+        append_end(0),
+        checksum_enabled(false),
+        checksum(0),
+        levels_enabled(false),
+        dither(kNoDither),
+        dither_seed(0),
+        regions_loaded(false) {}
+
+  bool is_open() const { return stream != nullptr && stream->is_open(); }
+  bool is_open(OpenMode open_mode) const {
+    return is_open() && mode == open_mode;
+  }
+  // samples and chunks can be read in every mode but kOut
+  bool can_read() const {
+    return is_open(kIn) || is_open(kUpdate) || is_open(kAppend);
+  }
+  bool can_write() const { return is_open(kOut) || is_open(kAppend); }
+
+  // RIFX files store sizes and samples big-endian
+  bool big_endian() const {
+    return memcmp(header.riff.chunk_id, "RIFX", 4) == 0;
+  }
+
   Error WriteHeader(uint64_t data_size) {
-    if (!ostream.is_open()) {
+    if (!is_open(kOut)) {
       return kNotOpen;
     }
-    auto original_position = ostream.tellp();
+    auto original_position = stream->Tell();
     // Position to beginning of file
-    ostream.seekp(0);
+    stream->Seek(0);
 
     // make header
     auto bits_per_sample = header.fmt.bits_per_sample;
@@ -52,14 +108,16 @@ class File::Impl {
     // data header
     header.data.sub_chunk_2_size = data_size * bytes_per_sample;
 
-    ostream.write(reinterpret_cast<char*>(&header), sizeof(WAVEHeader));
-    if (ostream.fail()) {
+    auto file_header = header;
+    ConvertByteOrder(big_endian(), &file_header);
+    if (stream->Write(reinterpret_cast<char*>(&file_header),
+                      sizeof(WAVEHeader)) != sizeof(WAVEHeader)) {
       return kWriteError;
     }
 
     // reposition to old position if was > to current position
-    if (ostream.tellp() < original_position) {
-      ostream.seekp(original_position);
+    if (stream->Tell() < original_position) {
+      stream->Seek(original_position);
     }
 
     // the offset of data will be right after the headers
@@ -69,32 +127,103 @@ class File::Impl {
   
   template <typename T>
   void ReadHeader(Header generic_header, T* output) {
-    istream.seekg(generic_header.position(), std::ios::beg);
-    istream.read(reinterpret_cast<char*>(output), sizeof(T));
+    walker.Read(generic_header.position(), reinterpret_cast<char*>(output),
+                sizeof(T));
+    // the RIFF header is read first and gives the byte order
+    ConvertByteOrder(big_endian(), output);
   }
-  
-  Error ReadHeader(HeaderList* headers) {
-    if (!istream.is_open()) {
+
+  // Add the chunks following the ones already listed, RIFF header first, up
+  // to the first one with last_id or to the end of the file
+  void ListChunks(const std::string& last_id) {
+    auto original_position = stream->Tell();
+    auto file_size = stream->Size();
+    uint64_t position = 0;
+    if (!chunks.empty()) {
+      position = chunks.back().position() + chunks.back().chunk_size();
+    }
+    while (!chunks_listed) {
+      Header chunk;
+      if (position + Header::kSize > file_size ||
+          !walker.ReadHeader(position, &chunk)) {
+        chunks_listed = true;
+        break;
+      }
+      chunks.push_back(chunk);
+      position += chunk.chunk_size();
+      // stop on truncated files
+      if (position > file_size) {
+        chunks_listed = true;
+      }
+      if (chunk.chunk_id() == last_id) {
+        break;
+      }
+    }
+    stream->Seek(original_position);
+  }
+
+  // Chunks following the samples are only listed when they are needed
+  void ListAllChunks() {
+    if (can_read()) {
+      ListChunks("");
+    }
+  }
+
+  // index of the first chunk with given ID, or chunks.size() if none
+  size_t FindChunk(const std::string& id) const {
+    for (size_t idx = 0; idx < chunks.size(); idx++) {
+      if (chunks[idx].chunk_id() == id) {
+        return idx;
+      }
+    }
+    return chunks.size();
+  }
+
+  // the RIFF header is used when a chunk is missing, which fails the checks
+  Header chunk(const std::string& id) const {
+    auto idx = FindChunk(id);
+    return idx < chunks.size() ? chunks[idx] : chunks.front();
+  }
+
+  Error ReadHeader() {
+    if (!can_read()) {
       return kNotOpen;
     }
-    istream.seekg(0, std::ios::end);
-    auto file_size = istream.tellg();
     // If not enough data
+    auto file_size = stream->Size();
     if (file_size < sizeof(WAVEHeader)) {
       return kInvalidFormat;
     }
-    istream.seekg(0, std::ios::beg);
-    
+    // a single read gives the headers in front of the samples of most files,
+    // whatever follows the samples
+    auto block_size = walker.Open(
+        [this](uint64_t position, char* data, uint64_t size) -> uint64_t {
+          return stream->Seek(position) ? stream->Read(data, size) : 0;
+        },
+        file_size);
+    if (block_size != std::min(ChunkWalker::kBlockSize, file_size)) {
+      return kReadError;
+    }
+    chunks.clear();
+    chunks_listed = false;
+    ListChunks("data");
+    if (FindChunk("fmt ") == chunks.size()) {
+      ListAllChunks();
+    }
+
     // read headers
-    ReadHeader(headers->riff(), &header.riff);
-    ReadHeader(headers->fmt(), &header.fmt);
-    ReadHeader(headers->data(), &header.data);
+    auto data_header = chunk("data");
+    ReadHeader(chunks.front(), &header.riff);
+    ReadHeader(chunk("fmt "), &header.fmt);
+    ReadHeader(data_header, &header.data);
     // data offset is right after data header's ID and size
-    auto data_header = headers->data();
-    data_offset_ = data_header.position() + sizeof(data_header.chunk_size()) + (data_header.chunk_id().size() * sizeof(char));
+    data_offset_ = data_header.position() + Header::kSize;
+    // headers share our stream, make sure we stand at the data start
+    stream->Seek(data_offset_);
 
     // check headers ids (make sure they are set)
-    if (std::string(header.riff.chunk_id, 4) != "RIFF") {
+    auto riff_id = std::string(header.riff.chunk_id, 4);
+    if (riff_id != "RIFF" && riff_id != "RIFX") {
       return kInvalidFormat;
     }
     if (std::string(header.riff.format, 4) != "WAVE") {
@@ -107,9 +236,8 @@ class File::Impl {
       return kInvalidFormat;
     }
 
-    // we only support 8 / 16 / 32  bit per sample
-    auto bps = header.fmt.bits_per_sample;
-    if (bps != 8 && bps != 16 && bps != 32) {
+    // we only support 8 / 16 / 24 / 32  bit per sample
+    if (!internal::IsSupportedBitsPerSample(header.fmt.bits_per_sample)) {
       return kInvalidFormat;
     }
     
@@ -121,17 +249,752 @@ class File::Impl {
     return kNoError;
   }
 
-  uint64_t current_sample_index() {
+  // Start using the given stream, once it is opened
+  Error Open(Stream* opened_stream, OpenMode open_mode) {
+    stream = opened_stream;
+    mode = open_mode;
+    checksum = 0;
+    dither_errors.clear();
+    reserved = false;
+    presized = false;
+    if (mode == kOut) {
+      return WriteHeader(0);
+    }
+    auto error = ReadHeader();
+    if (error != kNoError || mode != kAppend) {
+      return error;
+    }
+    return PrepareAppend();
+  }
+
+  // Keep the chunks following the samples aside, they are written back after
+  // the new samples on Close. Everything before the end of data stays in
+  // place so appending costs the size of the new samples only.
+  Error PrepareAppend() {
+    append_format = header.fmt;
+    append_end = stream->Size();
+    // the declared size can't be trusted on truncated recordings
+    uint64_t data_size = std::min<uint64_t>(header.data.sub_chunk_2_size,
+                                            append_end - data_offset_);
+    header.data.sub_chunk_2_size = static_cast<uint32_t>(data_size);
+
+    ListAllChunks();
+    auto data_idx = FindChunk("data");
+    for (auto idx = data_idx + 1; idx < chunks.size(); idx++) {
+      auto id = chunks[idx].chunk_id();
+      if (id == "JUNK") {
+        continue;
+      }
+      std::vector<char> content(chunks[idx].content_size());
+      stream->Seek(chunks[idx].position() + Header::kSize);
+      if (stream->Read(content.data(), content.size()) != content.size()) {
+        return kReadError;
+      }
+      pending_chunks.push_back(std::make_pair(id, content));
+    }
+    chunks.resize(data_idx + 1);
+
+    stream->Seek(data_offset_ + data_size);
+    return kNoError;
+  }
+
+  // Only the size fields are updated in kAppend mode, the headers in front of
+  // data may not have the layout WriteHeader writes
+  Error WriteDataSize(uint64_t data_size) {
+    if (is_open(kOut)) {
+      return WriteHeader(data_size);
+    }
+    auto original_position = stream->Tell();
+    header.data.sub_chunk_2_size =
+        static_cast<uint32_t>(data_size * (header.fmt.bits_per_sample / 8));
+    auto error = WriteRIFFSize(data_offset_ + header.data.sub_chunk_2_size);
+    auto size =
+        internal::ToFileOrder(header.data.sub_chunk_2_size, big_endian());
+    if (error == kNoError &&
+        (!stream->Seek(data_offset_ - sizeof(size)) ||
+         stream->Write(reinterpret_cast<char*>(&size), sizeof(size)) !=
+             sizeof(size))) {
+      error = kWriteError;
+    }
+    stream->Seek(original_position);
+    return error;
+  }
+
+  // Samples are checksummed as stored, encrypted or not
+  void UpdateChecksum(const char* data, size_t size) {
+    if (checksum_enabled) {
+      checksum = internal::Crc32c(checksum, data, size);
+    }
+  }
+
+  // Checks shared by Write and WriteRaw. Storage is reserved for the expected
+  // frames at the first write.
+  Error BeginWrite() {
+    if (!can_write()) {
+      return kNotOpen;
+    }
     auto bits_per_sample = header.fmt.bits_per_sample;
+    if (!internal::IsSupportedBitsPerSample(bits_per_sample)) {
+      return kInvalidFormat;
+    }
+    // appended samples have to match the existing ones
+    if (is_open(kAppend) &&
+        (append_format.num_channel != header.fmt.num_channel ||
+         append_format.sample_rate != header.fmt.sample_rate ||
+         append_format.bits_per_sample != bits_per_sample)) {
+      return kInvalidFormat;
+    }
+    if (!reserved && expected_frame_number > 0) {
+      if (is_open(kOut)) {
+        auto error = WriteExpectedHeader();
+        if (error != kNoError) {
+          return error;
+        }
+      }
+      stream->Reserve(stream->Tell() + expected_frame_number *
+                                           header.fmt.num_channel *
+                                           (bits_per_sample / 8));
+      reserved = true;
+    }
+    return kNoError;
+  }
+
+  // In kOut mode, the header gives the expected frames from the first write
+  // on. It is only written again on Close, when the frames actually written
+  // are not the expected ones.
+  Error WriteExpectedHeader() {
+    auto data_size = header.data.sub_chunk_2_size;
+    auto error = WriteHeader(expected_frame_number * header.fmt.num_channel);
+    // the size of what was written so far is kept for frame_number
+    header.data.sub_chunk_2_size = data_size;
+    presized = error == kNoError;
+    return error;
+  }
+
+  Error EndExpectedWrite() {
+    if (!presized) {
+      return kNoError;
+    }
+    presized = false;
+    uint64_t sample_number =
+        header.data.sub_chunk_2_size / (header.fmt.bits_per_sample / 8);
+    if (sample_number == expected_frame_number * header.fmt.num_channel) {
+      return kNoError;
+    }
+    return WriteHeader(sample_number);
+  }
+
+  // Update the headers once samples were written up to given sample index
+  Error EndWrite(uint64_t sample_index) {
+    // regions may extend to the end of data
+    regions_loaded = false;
+    if (presized) {
+      UpdateExpectedDataSize(sample_index);
+      return kNoError;
+    }
+    if (is_open(kAppend)) {
+      // samples written after a Seek may not reach the end of data
+      sample_index = std::max(sample_index, sample_number());
+    }
+    return WriteDataSize(sample_index);
+  }
+
+  // Checks shared by Read and ReadRaw
+  Error BeginRead(uint64_t requested_samples) {
+    if (!can_read()) {
+      return kNotOpen;
+    }
+    // check if we have enough data available
+    if (sample_number() < requested_samples + current_sample_index()) {
+      return kInvalidFormat;
+    }
+    if (!internal::IsSupportedBitsPerSample(header.fmt.bits_per_sample)) {
+      return kInvalidFormat;
+    }
+    return kNoError;
+  }
+
+  // Gains of each channel for the next Read or Write
+  Error PrepareGains() {
+    auto channel_number = header.fmt.num_channel;
+    if (gains.size() == channel_number) {
+      channel_gains = gains;
+    } else if (gains.size() <= 1) {
+      channel_gains.assign(channel_number, gains.empty() ? 1.f : gains[0]);
+    } else {
+      return kInvalidFormat;
+    }
+    if (levels_enabled && peaks.size() != channel_number) {
+      peaks.assign(channel_number, 0.f);
+      sums_of_squares.assign(channel_number, 0.);
+    }
+    return kNoError;
+  }
+
+  // Mix matrix for the next Read, mixing only applies to floating point
+  // samples
+  template <typename T>
+  Error PrepareMix() {
+    mix_matrix.clear();
+    if (mix_rows.empty()) {
+      return kNoError;
+    }
+    if (!std::is_floating_point<T>::value) {
+      return kInvalidFormat;
+    }
+    for (const auto& row : mix_rows) {
+      if (row.size() != header.fmt.num_channel) {
+        return kInvalidFormat;
+      }
+      mix_matrix.insert(mix_matrix.end(), row.begin(), row.end());
+    }
+    return kNoError;
+  }
+
+  bool has_processing() const { return !gains.empty() || levels_enabled; }
+
+  // gain and levels apply to floating point samples only
+  template <typename T>
+  void Process(T* samples, size_t sample_number, size_t first_channel) {}
+  void Process(float* samples, size_t sample_number, size_t first_channel) {
+    ProcessFloatingPoint(samples, sample_number, first_channel);
+  }
+  void Process(double* samples, size_t sample_number, size_t first_channel) {
+    ProcessFloatingPoint(samples, sample_number, first_channel);
+  }
+  template <typename T>
+  void ProcessFloatingPoint(T* samples, size_t sample_number,
+                            size_t first_channel) {
+    if (!has_processing()) {
+      return;
+    }
+    internal::ApplyGain(samples, sample_number, channel_gains.size(),
+                        first_channel, channel_gains.data(),
+                        levels_enabled ? peaks.data() : nullptr,
+                        sums_of_squares.data());
+  }
+
+  template <typename T>
+  Error Read(uint64_t requested_samples, void (*decrypt)(char*, size_t),
+             std::vector<T>* output) {
+    auto error = PrepareRead<T>(requested_samples);
+    if (error != kNoError) {
+      return error;
+    }
+    // resize output to desired size
+    output->resize(requested_samples / header.fmt.num_channel *
+                   output_channel_number());
+    return ReadSamples(requested_samples, decrypt, output->data());
+  }
+
+  template <typename T>
+  Error Read(uint64_t requested_samples, void (*decrypt)(char*, size_t),
+             T* output) {
+    auto error = PrepareRead<T>(requested_samples);
+    if (error != kNoError) {
+      return error;
+    }
+    return ReadSamples(requested_samples, decrypt, output);
+  }
+
+  template <typename T>
+  Error PrepareRead(uint64_t requested_samples) {
+    auto error = BeginRead(requested_samples);
+    if (error == kNoError) {
+      error = PrepareGains();
+    }
+    if (error == kNoError) {
+      error = PrepareMix<T>();
+    }
+    return error;
+  }
+
+  // channels of the frames given by Read
+  size_t output_channel_number() const {
+    return mix_matrix.empty() ? header.fmt.num_channel : mix_rows.size();
+  }
+
+  // Read requested_samples samples into output, which has room for them
+  // once mixed. PrepareRead must have succeeded.
+  template <typename T>
+  Error ReadSamples(uint64_t requested_samples,
+                    void (*decrypt)(char*, size_t), T* output) {
+    auto channel_number = header.fmt.num_channel;
+    auto bits_per_sample = header.fmt.bits_per_sample;
+    auto mixing = !mix_matrix.empty();
+    auto big_endian_samples = big_endian();
+    auto output_channel_number = this->output_channel_number();
+
+    // read and decode block by block so the scratch buffer stays small
     auto bytes_per_sample = bits_per_sample / 8;
-    uint64_t data_index = 0;
-    if (ostream.is_open()) {
-      data_index = static_cast<uint64_t>(ostream.tellp()) - data_offset_;
-    } else if (istream.is_open()) {
-      data_index = static_cast<uint64_t>(istream.tellg()) - data_offset_;
+    uint64_t block_samples = internal::kBlockSize / bytes_per_sample;
+    if (mixing) {
+      // blocks of whole frames, decoded in sample_buffer then mixed into
+      // output
+      block_samples = std::max<uint64_t>(
+          channel_number, block_samples - block_samples % channel_number);
+      sample_buffer.resize(block_samples * sizeof(T));
+      mix_buffer.resize((channel_number + output_channel_number) *
+                        internal::kMixFrames * sizeof(T));
+    }
+    if (buffer.size() < block_samples * bytes_per_sample) {
+      buffer.resize(block_samples * bytes_per_sample);
+    }
+    for (uint64_t sample_idx = 0; sample_idx < requested_samples;
+         sample_idx += block_samples) {
+      auto sample_count =
+          std::min(block_samples, requested_samples - sample_idx);
+      auto byte_count = sample_count * bytes_per_sample;
+      // decode in place when the stream allows it and nothing has to be
+      // decrypted
+      const char* block = nullptr;
+      if (decrypt == internal::NoDecrypt) {
+        block = stream->ReadView(byte_count);
+      }
+      auto view = block != nullptr;
+      if (!view) {
+        if (stream->Read(buffer.data(), byte_count) != byte_count) {
+          return kReadError;
+        }
+        UpdateChecksum(buffer.data(), byte_count);
+        if (decrypt != internal::NoDecrypt) {
+          for (uint64_t offset = 0; offset < byte_count;
+               offset += bytes_per_sample) {
+            decrypt(buffer.data() + offset, bytes_per_sample);
+          }
+        }
+        block = buffer.data();
+      }
+      auto samples = mixing ? reinterpret_cast<T*>(sample_buffer.data())
+                            : output + sample_idx;
+      internal::Decode(block, bits_per_sample, sample_count, samples,
+                       big_endian_samples);
+      // a view is read from memory by the decoding, its checksum follows
+      // while it is in cache
+      if (view) {
+        UpdateChecksum(block, byte_count);
+      }
+      // while the block is still in cache
+      Process(samples, sample_count, sample_idx % channel_number);
+      if (mixing) {
+        internal::Mix(samples, sample_count / channel_number, channel_number,
+                      mix_matrix.data(), output_channel_number,
+                      reinterpret_cast<T*>(mix_buffer.data()),
+                      output +
+                          sample_idx / channel_number * output_channel_number);
+      }
+    }
+    return kNoError;
+  }
+
+  template <typename T>
+  Error Write(const std::vector<T>& data,
+              void (*encrypt)(char* data, size_t size), bool clip) {
+    auto error = BeginWrite();
+    if (error == kNoError) {
+      error = PrepareGains();
+    }
+    if (error != kNoError) {
+      return error;
+    }
+    auto current_data_size = current_sample_index();
+    auto bits_per_sample = header.fmt.bits_per_sample;
+    auto bytes_per_sample = bits_per_sample / 8;
+    auto channel_number = header.fmt.num_channel;
+    auto big_endian_samples = big_endian();
+    // quantization to 24 and 32 bits is below the precision of float
+    auto dithering = dither != kNoDither &&
+                     std::is_floating_point<T>::value && bits_per_sample <= 16;
+    if (dithering && dither_errors.size() != channel_number) {
+      dither_errors.assign(channel_number, 0.f);
+    }
+
+    // encode block by block in the scratch buffer and write each block at
+    // once
+    uint64_t block_samples = internal::kBlockSize / bytes_per_sample;
+    if (buffer.size() < block_samples * bytes_per_sample) {
+      buffer.resize(block_samples * bytes_per_sample);
+    }
+    for (uint64_t sample_idx = 0; sample_idx < data.size();
+         sample_idx += block_samples) {
+      auto sample_count =
+          std::min<uint64_t>(block_samples, data.size() - sample_idx);
+      auto byte_count = sample_count * bytes_per_sample;
+      auto samples = data.data() + sample_idx;
+      if (has_processing()) {
+        // data is left untouched, gain is applied to a copy of the block
+        sample_buffer.resize(block_samples * sizeof(T));
+        auto processed = reinterpret_cast<T*>(sample_buffer.data());
+        std::copy(samples, samples + sample_count, processed);
+        Process(processed, sample_count, sample_idx % channel_number);
+        samples = processed;
+      }
+      if (dithering) {
+        // noise of the samples depends on their position in file
+        internal::EncodeDithered(
+            samples, sample_count, bits_per_sample, clip, dither_seed,
+            current_data_size + sample_idx, channel_number,
+            sample_idx % channel_number,
+            dither == kNoiseShapedDither ? dither_errors.data() : nullptr,
+            buffer.data(), big_endian_samples);
+      } else {
+        internal::Encode(samples, sample_count, bits_per_sample, clip,
+                         buffer.data(), big_endian_samples);
+      }
+      if (encrypt != internal::NoEncrypt) {
+        for (uint64_t offset = 0; offset < byte_count;
+             offset += bytes_per_sample) {
+          encrypt(buffer.data() + offset, bytes_per_sample);
+        }
+      }
+      UpdateChecksum(buffer.data(), byte_count);
+      if (stream->Write(buffer.data(), byte_count) != byte_count) {
+        return kWriteError;
+      }
+    }
+
+    // update header to show the right data size
+    return EndWrite(current_data_size + data.size());
+  }
+
+  // The data size of the header in memory follows the end of the samples
+  // written, from Write or WriteAt, the one in file is left as is
+  void UpdateExpectedDataSize(uint64_t sample_index) {
+    std::lock_guard<std::mutex> lock(write_at_mutex);
+    header.data.sub_chunk_2_size = std::max<uint32_t>(
+        header.data.sub_chunk_2_size,
+        static_cast<uint32_t>(sample_index *
+                              (header.fmt.bits_per_sample / 8)));
+  }
+
+  // Write encoded samples at given byte position, in parallel when the
+  // stream allows it
+  Error WriteSamplesAt(uint64_t position, const char* data, uint64_t size) {
+    if (stream->can_write_at()) {
+      return stream->WriteAt(position, data, size) == size ? kNoError
+                                                           : kWriteError;
+    }
+    std::lock_guard<std::mutex> lock(write_at_mutex);
+    auto original_position = stream->Tell();
+    uint64_t written = 0;
+    if (stream->Seek(position)) {
+      written = stream->Write(data, size);
+    }
+    stream->Seek(original_position);
+    return written == size ? kNoError : kWriteError;
+  }
+
+  // Read encoded samples at given byte position, in parallel when the stream
+  // allows it
+  Error ReadSamplesAt(uint64_t position, char* data, uint64_t size) {
+    if (stream->can_read_at()) {
+      return stream->ReadAt(position, data, size) == size ? kNoError
+                                                          : kReadError;
+    }
+    std::lock_guard<std::mutex> lock(read_at_mutex);
+    auto original_position = stream->Tell();
+    uint64_t read = 0;
+    if (stream->Seek(position)) {
+      read = stream->Read(data, size);
+    }
+    stream->Seek(original_position);
+    return read == size ? kNoError : kReadError;
+  }
+
+  Error WriteAt(uint64_t frame_index, const std::vector<float>& data,
+                bool clip) {
+    if (!is_open(kOut)) {
+      return kNotOpen;
+    }
+    auto channel_number = header.fmt.num_channel;
+    if (expected_frame_number == 0 || data.size() % channel_number != 0 ||
+        frame_index + data.size() / channel_number > expected_frame_number) {
+      return kInvalidFormat;
+    }
+    {
+      // the first write gives the header and reserves storage
+      std::lock_guard<std::mutex> lock(write_at_mutex);
+      if (!presized) {
+        auto error = BeginWrite();
+        if (error != kNoError) {
+          return error;
+        }
+      }
+    }
+    auto bits_per_sample = header.fmt.bits_per_sample;
+    auto bytes_per_sample = bits_per_sample / 8;
+    auto big_endian_samples = big_endian();
+    // the noise of TPDF dither only depends on the position of samples
+    auto dithering = dither != kNoDither && bits_per_sample <= 16;
+    uint64_t first_sample = frame_index * channel_number;
+
+    // encoded block by block in a buffer of the calling thread
+    thread_local std::vector<char> encoded;
+    uint64_t block_samples = internal::kBlockSize / bytes_per_sample;
+    encoded.resize(block_samples * bytes_per_sample);
+    for (uint64_t sample_idx = 0; sample_idx < data.size();
+         sample_idx += block_samples) {
+      auto sample_count =
+          std::min<uint64_t>(block_samples, data.size() - sample_idx);
+      auto samples = data.data() + sample_idx;
+      if (dithering) {
+        internal::EncodeDithered(samples, sample_count, bits_per_sample, clip,
+                                 dither_seed, first_sample + sample_idx,
+                                 channel_number, sample_idx % channel_number,
+                                 nullptr, encoded.data(), big_endian_samples);
+      } else {
+        internal::Encode(samples, sample_count, bits_per_sample, clip,
+                         encoded.data(), big_endian_samples);
+      }
+      auto error = WriteSamplesAt(
+          data_offset_ + (first_sample + sample_idx) * bytes_per_sample,
+          encoded.data(), sample_count * bytes_per_sample);
+      if (error != kNoError) {
+        return error;
+      }
+    }
+    UpdateExpectedDataSize(first_sample + data.size());
+    return kNoError;
+  }
+
+  // Read the first chunk with given ID. List chunks can be filtered by the
+  // list type their content starts with.
+  Error ReadChunk(const std::string& id, std::vector<char>* content,
+                  const std::string& type = "") {
+    auto has_type = [&type](const std::vector<char>& chunk_content) {
+      return chunk_content.size() >= type.size() &&
+             std::equal(type.begin(), type.end(), chunk_content.begin());
+    };
+    if (can_write()) {
+      for (auto& pending_chunk : pending_chunks) {
+        if (pending_chunk.first == id && has_type(pending_chunk.second)) {
+          *content = pending_chunk.second;
+          return kNoError;
+        }
+      }
+    }
+    if (!can_read()) {
+      return is_open(kOut) ? kChunkNotFound : kNotOpen;
+    }
+    ListAllChunks();
+    auto original_position = stream->Tell();
+    std::vector<char> chunk_content;
+    for (auto& chunk : chunks) {
+      if (chunk.chunk_id() != id) {
+        continue;
+      }
+      chunk_content.resize(chunk.content_size());
+      stream->Seek(chunk.position() + Header::kSize);
+      auto read_size =
+          stream->Read(chunk_content.data(), chunk_content.size());
+      if (read_size != chunk_content.size()) {
+        stream->Seek(original_position);
+        return kReadError;
+      }
+      if (has_type(chunk_content)) {
+        stream->Seek(original_position);
+        std::swap(*content, chunk_content);
+        return kNoError;
+      }
+    }
+    stream->Seek(original_position);
+    return kChunkNotFound;
+  }
+
+  // Parse the cue points and their labels, once until they may change
+  Error LoadRegions() {
+    if (regions_loaded) {
+      return kNoError;
+    }
+    std::vector<char> cue;
+    auto error = ReadChunk("cue ", &cue);
+    if (error != kNoError) {
+      return error;
+    }
+    std::vector<char> associated_data;
+    error = ReadChunk("LIST", &associated_data, "adtl");
+    if (error != kNoError && error != kChunkNotFound) {
+      return error;
+    }
+    error = ParseRegions(cue, associated_data,
+                         sample_number() / header.fmt.num_channel,
+                         big_endian(), &regions);
+    if (error != kNoError) {
+      return error;
+    }
+    region_indices.clear();
+    for (size_t idx = 0; idx < regions.size(); idx++) {
+      region_indices.insert(std::make_pair(regions[idx].id, idx));
+    }
+    regions_loaded = true;
+    return kNoError;
+  }
+
+  // region with given id, nullptr if none
+  const Region* FindRegion(uint32_t id) const {
+    auto found = region_indices.find(id);
+    return found == region_indices.end() ? nullptr : &regions[found->second];
+  }
+
+  Error WriteChunkAt(uint64_t position, const std::string& id,
+                     const std::vector<char>& content) {
+    uint32_t size = static_cast<uint32_t>(content.size());
+    auto file_size = internal::ToFileOrder(size, big_endian());
+    char padding = 0;
+    if (!stream->Seek(position) || stream->Write(id.data(), 4) != 4 ||
+        stream->Write(reinterpret_cast<char*>(&file_size),
+                      sizeof(file_size)) != sizeof(file_size) ||
+        stream->Write(content.data(), content.size()) != content.size() ||
+        stream->Write(&padding, size & 1) != (size & 1)) {
+      return kWriteError;
+    }
+    return kNoError;
+  }
+
+  // Mark size bytes at position as padding
+  Error WriteJunk(uint64_t position, uint64_t size) {
+    uint32_t content_size = internal::ToFileOrder(
+        static_cast<uint32_t>(size - Header::kSize),
+        big_endian());
+    if (!stream->Seek(position) || stream->Write("JUNK", 4) != 4 ||
+        stream->Write(reinterpret_cast<char*>(&content_size),
+                      sizeof(content_size)) != sizeof(content_size)) {
+      return kWriteError;
+    }
+    return kNoError;
+  }
+
+  Error WriteRIFFSize(uint64_t end) {
+    header.riff.chunk_size = static_cast<uint32_t>(end - Header::kSize);
+    auto size = internal::ToFileOrder(header.riff.chunk_size, big_endian());
+    if (!stream->Seek(sizeof(header.riff.chunk_id)) ||
+        stream->Write(reinterpret_cast<char*>(&size), sizeof(size)) !=
+            sizeof(size)) {
+      return kWriteError;
+    }
+    return kNoError;
+  }
+
+  // Write the chunk in place when it fits in its slot (and the padding
+  // following it), in a padding chunk large enough, or at the end of the
+  // file. The last chunk of the file can grow or shrink in place. Samples
+  // are never moved.
+  Error UpdateChunk(const std::string& id, const std::vector<char>& content) {
+    uint64_t needed =
+        Header::kSize + content.size() + (content.size() & 1);
+    // what is left has to be large enough for a padding chunk
+    auto fits = [needed](uint64_t available) {
+      return available == needed || available >= needed + Header::kSize;
+    };
+    ListAllChunks();
+    auto original_position = stream->Tell();
+    // bytes left after the last chunk are too few for a chunk header, and
+    // not part of the file
+    auto& last_chunk = chunks.back();
+    uint64_t end = last_chunk.position() + last_chunk.chunk_size();
+
+    uint64_t position = end;
+    uint64_t available = needed;
+    auto shrink = false;
+    auto idx = FindChunk(id);
+    if (idx < chunks.size()) {
+      uint64_t slot = chunks[idx].chunk_size();
+      auto is_last = idx + 1 == chunks.size();
+      if (!is_last && chunks[idx + 1].chunk_id() == "JUNK") {
+        slot += chunks[idx + 1].chunk_size();
+        is_last = idx + 2 == chunks.size();
+      }
+      if (is_last || fits(slot)) {
+        position = chunks[idx].position();
+        // too little would be left for a padding chunk, the file ends sooner
+        available = fits(slot) ? slot : needed;
+        shrink = needed < slot && !fits(slot);
+      } else {
+        // the chunk moves to the end of the file, its slot becomes padding
+        auto error = WriteJunk(chunks[idx].position(), slot);
+        if (error != kNoError) {
+          return error;
+        }
+      }
     } else {
+      for (auto& junk : chunks) {
+        if (junk.chunk_id() == "JUNK" && fits(junk.chunk_size())) {
+          position = junk.position();
+          available = junk.chunk_size();
+          break;
+        }
+      }
+    }
+
+    auto error = WriteChunkAt(position, id, content);
+    if (error == kNoError && available > needed) {
+      error = WriteJunk(position + needed, available - needed);
+    }
+    if (error == kNoError && (position + needed > end || shrink)) {
+      error = WriteRIFFSize(position + needed);
+    }
+    stream->Flush();
+    if (error == kNoError) {
+      // list again from the file, the first block read may be outdated
+      walker.Clear();
+      chunks.clear();
+      chunks_listed = false;
+      ListAllChunks();
+    }
+    stream->Seek(original_position);
+    return error;
+  }
+
+  // Chunks given in kOut mode, or found after the samples in kAppend mode, go
+  // after the samples
+  Error WritePendingChunks() {
+    if (pending_chunks.empty() && !is_open(kAppend)) {
+      return kNoError;
+    }
+    uint64_t position = data_offset_ + header.data.sub_chunk_2_size;
+    char padding = 0;
+    if (header.data.sub_chunk_2_size & 1) {
+      if (!stream->Seek(position) || stream->Write(&padding, 1) != 1) {
+        return kWriteError;
+      }
+      position++;
+    }
+    for (auto& pending_chunk : pending_chunks) {
+      auto error =
+          WriteChunkAt(position, pending_chunk.first, pending_chunk.second);
+      if (error != kNoError) {
+        return error;
+      }
+      position = stream->Tell();
+    }
+    if (is_open(kAppend) && position < append_end) {
+      // what is left of the previous chunks becomes padding, grown to hold
+      // at least a chunk header
+      auto junk_size = std::max<uint64_t>(append_end - position,
+                                          Header::kSize + 1) & ~1ull;
+      auto error = WriteJunk(position, junk_size);
+      if (error != kNoError) {
+        return error;
+      }
+      position += junk_size;
+      if (stream->Size() < position) {
+        std::vector<char> zeros(position - stream->Size(), 0);
+        if (!stream->Seek(stream->Size()) ||
+            stream->Write(zeros.data(), zeros.size()) != zeros.size()) {
+          return kWriteError;
+        }
+      }
+    }
+    return WriteRIFFSize(position);
+  }
+
+  uint64_t current_sample_index() {
+    auto bits_per_sample = header.fmt.bits_per_sample;
+    auto bytes_per_sample = bits_per_sample / 8;
+    if (!is_open()) {
       return 0;
     }
+    uint64_t data_index = stream->Tell() - data_offset_;
     return data_index / bytes_per_sample;
   }
 
@@ -139,12 +1002,9 @@ class File::Impl {
     auto bits_per_sample = header.fmt.bits_per_sample;
     auto bytes_per_sample = bits_per_sample / 8;
 
-    std::streampos stream_index =
-        data_offset_ + (sample_idx * bytes_per_sample);
-    if (ostream.is_open()) {
-      ostream.seekp(stream_index);
-    } else if (istream.is_open()) {
-      istream.seekg(stream_index);
+    uint64_t stream_index = data_offset_ + (sample_idx * bytes_per_sample);
+    if (is_open()) {
+      stream->Seek(stream_index);
     }
   }
 
@@ -156,18 +1016,137 @@ class File::Impl {
     return total_data_size / bytes_per_sample;
   }
 
-  std::ifstream istream;
-  std::ofstream ostream;
+  Error Close() {
+    // wait for the asynchronous writes
+    writer.reset();
+    auto error = kNoError;
+    if (can_write()) {
+      error = EndExpectedWrite();
+      auto chunk_error = WritePendingChunks();
+      if (error == kNoError) {
+        error = chunk_error;
+      }
+    }
+    pending_chunks.clear();
+    chunks.clear();
+    chunks_listed = false;
+    walker.Clear();
+    regions_loaded = false;
+    if (is_open()) {
+      if (!stream->Flush() && error == kNoError) {
+        error = kWriteError;
+      }
+      stream->Close();
+#ifdef WAVE_HAVE_DIRECT_IO
+      // the end of the file and the header updates are written on Close
+      if (stream == &direct_stream && direct_stream.failed() &&
+          error == kNoError) {
+        error = kWriteError;
+      }
+#endif  // WAVE_HAVE_DIRECT_IO
+    }
+    stream = nullptr;
+    path.clear();
+    if (backend != nullptr) {
+      backend->Close(backend_handle);
+      backend = nullptr;
+      backend_handle = -1;
+    }
+    return error;
+  }
+
+  // the streams File can be opened on. They are kept alive across Reset to
+  // make File reusable at no cost
+  FileStream file_stream;
+  MemoryStream memory_stream;
+  VectorStream vector_stream;
+#ifdef WAVE_HAVE_DIRECT_IO
+  DirectFileStream direct_stream;
+#endif  // WAVE_HAVE_DIRECT_IO
+  // the one currently opened
+  Stream* stream;
+  OpenMode mode;
+
+  // path of the opened file, empty when opened on a buffer
+  std::string path;
+
   WAVEHeader header;
   uint64_t data_offset_;
+
+  // chunks of the file, up to data in kAppend mode. Only the chunks up to
+  // data are listed when the file is opened, the others on first use.
+  std::vector<Header> chunks;
+  bool chunks_listed;
+  // reads chunk headers, from the first bytes of the file read at once when
+  // it is opened
+  ChunkWalker walker;
+  // chunks to write after the samples, in kOut and kAppend mode
+  std::vector<std::pair<std::string, std::vector<char>>> pending_chunks;
+
+  // asynchronous reads open their own handle on the file
+  IOBackend* backend;
+  int backend_handle;
+
+  // storage is reserved for the expected frames at the first write, and in
+  // kOut mode the header is written once for them
+  uint64_t expected_frame_number;
+  bool reserved;
+  bool presized;
+  // serializes the updates of WriteAt calls
+  std::mutex write_at_mutex;
+  // serializes ReadRawAt calls on streams without positional reads
+  std::mutex read_at_mutex;
+
+  // format of the file and its size when opened in kAppend mode
+  FMTHeader append_format;
+  uint64_t append_end;
+
+  // CRC32C of the samples read or written
+  bool checksum_enabled;
+  uint32_t checksum;
+
+  // gain given by the user, for all channels or each of them
+  std::vector<float> gains;
+  std::vector<float> channel_gains;
+  // levels of the samples read or written
+  bool levels_enabled;
+  std::vector<float> peaks;
+  std::vector<double> sums_of_squares;
+  // mix matrix given by the user, a row for each output channel, and its
+  // flattened version for the next Read
+  std::vector<std::vector<float>> mix_rows;
+  std::vector<float> mix_matrix;
+
+  // scratch buffers for encoding and decoding
+  std::vector<char> buffer;
+  std::vector<char> sample_buffer;
+  std::vector<char> mix_buffer;
+
+  // dither added when writing, and the quantization error of each channel
+  // for noise shaping
+  Dither dither;
+  uint64_t dither_seed;
+  std::vector<float> dither_errors;
+
+  // regions of the file sorted by first frame, loaded on first use, and
+  // their index by cue point id
+  bool regions_loaded;
+  std::vector<Region> regions;
+  std::unordered_map<uint32_t, size_t> region_indices;
+  // frames shared by overlapping regions
+  std::vector<float> region_buffer;
+
+  // runs asynchronous writes in order. Declared last so that pending writes
+  // are done before anything else gets destroyed
+  std::unique_ptr<ThreadPool> writer;
 };
 
 File::File() : impl_(new Impl()) {
   impl_->header = MakeWAVEHeader();
 }
 File::~File() {
-  if (impl_ != nullptr && impl_->istream.is_open()) {
-    impl_->ostream.flush();
+  if (impl_ != nullptr) {
+    impl_->Close();
   }
 #if __cplusplus < 201103L
   delete impl_;
@@ -175,24 +1154,67 @@ File::~File() {
 }
 
 Error File::Open(const std::string& path, OpenMode mode) {
+  std::ios::openmode open_mode = std::ios::in;
   if (mode == OpenMode::kOut) {
-    impl_->ostream.open(path.c_str(), std::ios::binary | std::ios::trunc);
-    if (!impl_->ostream.is_open()) {
-      return Error::kFailedToOpen;
-    }
-    return impl_->WriteHeader(0);
+    open_mode = std::ios::out | std::ios::trunc;
+  } else if (mode == OpenMode::kUpdate || mode == OpenMode::kAppend) {
+    open_mode = std::ios::in | std::ios::out;
   }
+  auto error = impl_->file_stream.Open(path, open_mode);
+  if (error != kNoError) {
+    return error;
+  }
+  impl_->path = path;
+  return impl_->Open(&impl_->file_stream, mode);
+}
+
+Error File::OpenBuffer(const void* data, size_t size) {
+  impl_->memory_stream.Open(static_cast<const char*>(data), size);
+  return impl_->Open(&impl_->memory_stream, kIn);
+}
 
-  impl_->istream.open(path.c_str(), std::ios::binary);
-  if (!impl_->istream.is_open()) {
-    return Error::kFailedToOpen;
+Error File::OpenBuffer(std::vector<char>* buffer, OpenMode mode) {
+  if (mode == kOut) {
+    buffer->clear();
   }
-  HeaderList headers;
-  auto error = headers.Init(path);
+  impl_->vector_stream.Open(buffer);
+  return impl_->Open(&impl_->vector_stream, mode);
+}
+
+Error File::OpenDirect(const std::string& path) {
+#ifdef WAVE_HAVE_DIRECT_IO
+  auto error = impl_->direct_stream.Open(path);
   if (error != kNoError) {
     return error;
   }
-  return impl_->ReadHeader(&headers);
+  impl_->path = path;
+  return impl_->Open(&impl_->direct_stream, kOut);
+#else
+  return Open(path, kOut);
+#endif  // WAVE_HAVE_DIRECT_IO
+}
+
+Error File::Reopen(const std::string& path, OpenMode mode) {
+  Reset();
+  return Open(path, mode);
+}
+
+Error File::Close() { return impl_->Close(); }
+
+void File::Reset() {
+  impl_->Close();
+  impl_->header = MakeWAVEHeader();
+  impl_->data_offset_ = 0;
+  impl_->expected_frame_number = 0;
+  impl_->reserved = false;
+  impl_->checksum_enabled = false;
+  impl_->checksum = 0;
+  impl_->gains.clear();
+  impl_->levels_enabled = false;
+  impl_->peaks.clear();
+  impl_->sums_of_squares.clear();
+  impl_->mix_rows.clear();
+  impl_->dither = kNoDither;
 }
 
 uint16_t File::channel_number() const { return impl_->header.fmt.num_channel; }
@@ -212,10 +1234,25 @@ void File::set_bits_per_sample(uint16_t bits_per_sample) {
   impl_->header.fmt.bits_per_sample = bits_per_sample;
 }
 
+bool File::big_endian() const { return impl_->big_endian(); }
+
+void File::set_big_endian(bool big_endian) {
+  strncpy(impl_->header.riff.chunk_id, big_endian ? "RIFX" : "RIFF", 4);
+}
+
 uint64_t File::frame_number() const {
   return impl_->sample_number() / channel_number();
 }
 
+void File::set_expected_frame_number(uint64_t frame_number) {
+  impl_->expected_frame_number = frame_number;
+}
+
+Error File::WriteAt(uint64_t frame_index, const std::vector<float>& data,
+                    bool clip) {
+  return impl_->WriteAt(frame_index, data, clip);
+}
+
 Error File::Read(std::vector<float>* output) {
   return Read(internal::NoDecrypt, output);
 }
@@ -230,129 +1267,398 @@ Error File::Read(uint64_t frame_number, std::vector<float>* output) {
 
 Error File::Read(uint64_t frame_number, void (*decrypt)(char*, size_t),
                  std::vector<float>* output) {
-  if (!impl_->istream.is_open()) {
-    return kNotOpen;
-  }
-  auto requested_samples = frame_number * channel_number();
+  return impl_->Read(frame_number * channel_number(), decrypt, output);
+}
 
-  // check if we have enough data available
-  if (impl_->sample_number() <
-      requested_samples + impl_->current_sample_index()) {
-    return kInvalidFormat;
+Error File::Read(uint64_t frame_number, float* output) {
+  return impl_->Read(frame_number * channel_number(), internal::NoDecrypt,
+                     output);
+}
+
+template <typename T>
+Error File::Read(std::vector<T>* output) {
+  return Read(frame_number(), output);
+}
+
+template <typename T>
+Error File::Read(uint64_t frame_number, std::vector<T>* output) {
+  return impl_->Read(frame_number * channel_number(), internal::NoDecrypt,
+                     output);
+}
+
+Error File::ReadRaw(uint64_t frame_number, std::vector<char>* output) {
+  return ReadRaw(frame_number, internal::NoDecrypt, output);
+}
+
+Error File::ReadRaw(uint64_t frame_number, void (*decrypt)(char*, size_t),
+                    std::vector<char>* output) {
+  auto requested_samples = frame_number * channel_number();
+  auto error = impl_->BeginRead(requested_samples);
+  if (error != kNoError) {
+    return error;
   }
-  // resize output to desired size
-  output->resize(requested_samples);
-
-  // read every sample one after another
-  for (size_t sample_idx = 0; sample_idx < output->size(); sample_idx++) {
-    if (impl_->header.fmt.bits_per_sample == 8) {
-      // 8bits case
-      int8_t value;
-      impl_->istream.read(reinterpret_cast<char*>(&value), sizeof(value));
-      decrypt(reinterpret_cast<char*>(&value), sizeof(value) / sizeof(char));
-      (*output)[sample_idx] =
-          static_cast<float>(value) / std::numeric_limits<int8_t>::max();
-    } else if (impl_->header.fmt.bits_per_sample == 16) {
-      // 16 bits
-      int16_t value;
-      impl_->istream.read(reinterpret_cast<char*>(&value), sizeof(value));
-      decrypt(reinterpret_cast<char*>(&value), sizeof(value) / sizeof(char));
-      (*output)[sample_idx] =
-          static_cast<float>(value) / std::numeric_limits<int16_t>::max();
-    } else if (impl_->header.fmt.bits_per_sample == 24) {
-      // 24bits int doesn't exist in c++. We create a 3 * 8bits struct to
-      // simulate
-      unsigned char value[3];
-      impl_->istream.read(reinterpret_cast<char*>(&value), sizeof(value));
-      decrypt(reinterpret_cast<char*>(&value), sizeof(value) / sizeof(char));
-      int integer_value;
-      // check if value is negative
-      if (value[2] & 0x80) {
-        integer_value =
-            (0xff << 24) | (value[2] << 16) | (value[1] << 8) | (value[0] << 0);
-      } else {
-        integer_value = (value[2] << 16) | (value[1] << 8) | (value[0] << 0);
-      }
-      (*output)[sample_idx] = static_cast<float>(integer_value) / INT24_MAX;
-    } else if (impl_->header.fmt.bits_per_sample == 32) {
-      // 32bits
-      int32_t value;
-      impl_->istream.read(reinterpret_cast<char*>(&value), sizeof(value));
-      decrypt(reinterpret_cast<char*>(&value), sizeof(value) / sizeof(char));
-      (*output)[sample_idx] =
-          static_cast<float>(value) / std::numeric_limits<int32_t>::max();
-    } else {
-      return kInvalidFormat;
+  // samples go straight to output, without any conversion
+  auto bytes_per_sample = impl_->header.fmt.bits_per_sample / 8;
+  output->resize(requested_samples * bytes_per_sample);
+  if (impl_->stream->Read(output->data(), output->size()) != output->size()) {
+    return kReadError;
+  }
+  impl_->UpdateChecksum(output->data(), output->size());
+  if (decrypt != internal::NoDecrypt) {
+    for (uint64_t offset = 0; offset < output->size();
+         offset += bytes_per_sample) {
+      decrypt(output->data() + offset, bytes_per_sample);
     }
   }
   return kNoError;
 }
 
+Error File::ReadRawAt(uint64_t frame_index, uint64_t frame_number,
+                      std::vector<char>* output) {
+  if (!impl_->can_read()) {
+    return kNotOpen;
+  }
+  if (frame_index > this->frame_number()) {
+    return kInvalidSeek;
+  }
+  if (frame_index + frame_number > this->frame_number() ||
+      !internal::IsSupportedBitsPerSample(bits_per_sample())) {
+    return kInvalidFormat;
+  }
+  uint64_t frame_size = channel_number() * (bits_per_sample() / 8);
+  output->resize(frame_number * frame_size);
+  return impl_->ReadSamplesAt(impl_->data_offset_ + frame_index * frame_size,
+                              output->data(), output->size());
+}
+
 Error File::Write(const std::vector<float>& data, bool clip) {
   return Write(data, internal::NoEncrypt, clip);
 }
 
 Error File::Write(const std::vector<float>& data,
                   void (*encrypt)(char* data, size_t size), bool clip) {
-  if (!impl_->ostream.is_open()) {
+  return impl_->Write(data, encrypt, clip);
+}
+
+template <typename T>
+Error File::Write(const std::vector<T>& data, bool clip) {
+  return impl_->Write(data, internal::NoEncrypt, clip);
+}
+
+Error File::WriteRaw(const std::vector<char>& data) {
+  return WriteRaw(data, internal::NoEncrypt);
+}
+
+Error File::WriteRaw(const std::vector<char>& data,
+                     void (*encrypt)(char* data, size_t size)) {
+  auto error = impl_->BeginWrite();
+  if (error != kNoError) {
+    return error;
+  }
+  auto bytes_per_sample = impl_->header.fmt.bits_per_sample / 8;
+  if (data.size() % (bytes_per_sample * channel_number()) != 0) {
+    return kInvalidFormat;
+  }
+  auto current_data_size = impl_->current_sample_index();
+
+  if (encrypt == internal::NoEncrypt) {
+    impl_->UpdateChecksum(data.data(), data.size());
+    if (impl_->stream->Write(data.data(), data.size()) != data.size()) {
+      return kWriteError;
+    }
+  } else {
+    // data is left untouched, samples are encrypted block by block in the
+    // scratch buffer
+    auto& buffer = impl_->buffer;
+    uint64_t block_size =
+        internal::kBlockSize / bytes_per_sample * bytes_per_sample;
+    if (buffer.size() < block_size) {
+      buffer.resize(block_size);
+    }
+    for (uint64_t offset = 0; offset < data.size(); offset += block_size) {
+      auto byte_count = std::min<uint64_t>(block_size, data.size() - offset);
+      memcpy(buffer.data(), data.data() + offset, byte_count);
+      for (uint64_t sample_offset = 0; sample_offset < byte_count;
+           sample_offset += bytes_per_sample) {
+        encrypt(buffer.data() + sample_offset, bytes_per_sample);
+      }
+      impl_->UpdateChecksum(buffer.data(), byte_count);
+      if (impl_->stream->Write(buffer.data(), byte_count) != byte_count) {
+        return kWriteError;
+      }
+    }
+  }
+
+  return impl_->EndWrite(current_data_size + data.size() / bytes_per_sample);
+}
+
+std::vector<std::string> File::chunk_ids() const {
+  std::vector<std::string> ids;
+  impl_->ListAllChunks();
+  for (auto& chunk : impl_->chunks) {
+    auto id = chunk.chunk_id();
+    if (id != "RIFF" && id != "fmt " && id != "data" && id != "JUNK") {
+      ids.push_back(id);
+    }
+  }
+  for (auto& pending_chunk : impl_->pending_chunks) {
+    ids.push_back(pending_chunk.first);
+  }
+  return ids;
+}
+
+Error File::ReadChunk(const std::string& id, std::vector<char>* content) {
+  return impl_->ReadChunk(id, content);
+}
+
+Error File::WriteChunk(const std::string& id,
+                       const std::vector<char>& content) {
+  // the headers are handled by File
+  if (id.size() != 4 || id == "RIFF" || id == "fmt " || id == "data") {
+    return kInvalidFormat;
+  }
+  impl_->regions_loaded = false;
+  if (impl_->is_open(kAppend)) {
+    // chunks in front of the samples are replaced by the one written on Close
+    auto idx = impl_->FindChunk(id);
+    if (idx < impl_->chunks.size()) {
+      auto original_position = impl_->stream->Tell();
+      auto error = impl_->WriteJunk(impl_->chunks[idx].position(),
+                                    impl_->chunks[idx].chunk_size());
+      impl_->stream->Seek(original_position);
+      if (error != kNoError) {
+        return error;
+      }
+      impl_->chunks.erase(impl_->chunks.begin() + idx);
+    }
+  }
+  if (impl_->can_write()) {
+    for (auto& pending_chunk : impl_->pending_chunks) {
+      if (pending_chunk.first == id) {
+        pending_chunk.second = content;
+        return kNoError;
+      }
+    }
+    impl_->pending_chunks.push_back(std::make_pair(id, content));
+    return kNoError;
+  }
+  if (!impl_->is_open(kUpdate)) {
     return kNotOpen;
   }
+  return impl_->UpdateChunk(id, content);
+}
 
-  auto current_data_size = impl_->current_sample_index();
-  auto bits_per_sample = impl_->header.fmt.bits_per_sample;
+void File::set_checksum_enabled(bool enabled) {
+  impl_->checksum_enabled = enabled;
+  impl_->checksum = 0;
+}
 
-  // write each samples
-  for (auto sample : data) {
-    // hard-clip if asked 
-    if (clip) {
-      if (sample > 1.f) {
-        sample = 1.f;
-      } else if (sample < -1.f) {
-        sample = -1.f;
-      }
-    }
-    if (bits_per_sample == 8) {
-      // 8bits case
-      int8_t value =
-          static_cast<int8_t>(sample * std::numeric_limits<int8_t>::max());
-      encrypt(reinterpret_cast<char*>(&value), sizeof(value) / sizeof(char));
-      impl_->ostream.write(reinterpret_cast<char*>(&value), sizeof(value));
-    } else if (bits_per_sample == 16) {
-      // 16 bits
-      int16_t value =
-          static_cast<int16_t>(sample * std::numeric_limits<int16_t>::max());
-      encrypt(reinterpret_cast<char*>(&value), sizeof(value) / sizeof(char));
-      impl_->ostream.write(reinterpret_cast<char*>(&value), sizeof(value));
-    } else if (bits_per_sample == 24) {
-      // 24bits int doesn't exist in c++. We create a 3 * 8bits struct to
-      // simulate
-      int v = sample * INT24_MAX;
-      int8_t value[3];
-      value[0] = reinterpret_cast<char*>(&v)[0];
-      value[1] = reinterpret_cast<char*>(&v)[1];
-      value[2] = reinterpret_cast<char*>(&v)[2];
-
-      encrypt(reinterpret_cast<char*>(&value), sizeof(value) / sizeof(char));
-      impl_->ostream.write(reinterpret_cast<char*>(&value), sizeof(value));
-    } else if (bits_per_sample == 32) {
-      // 32bits
-      int32_t value =
-          static_cast<int32_t>(sample * std::numeric_limits<int32_t>::max());
-      encrypt(reinterpret_cast<char*>(&value), sizeof(value) / sizeof(char));
-      impl_->ostream.write(reinterpret_cast<char*>(&value), sizeof(value));
-    } else {
-      return kInvalidFormat;
+uint32_t File::checksum() const { return impl_->checksum; }
+
+void File::set_gain(float gain) { impl_->gains.assign(1, gain); }
+void File::set_gain(const std::vector<float>& channel_gains) {
+  impl_->gains = channel_gains;
+}
+
+void File::set_dither(Dither dither, uint64_t seed) {
+  impl_->dither = dither;
+  impl_->dither_seed = seed;
+  impl_->dither_errors.clear();
+}
+
+void File::set_levels_enabled(bool enabled) {
+  impl_->levels_enabled = enabled;
+  impl_->peaks.clear();
+  impl_->sums_of_squares.clear();
+}
+
+std::vector<ChannelLevels> File::levels() const {
+  std::vector<ChannelLevels> levels(impl_->peaks.size());
+  for (size_t channel = 0; channel < levels.size(); channel++) {
+    levels[channel].peak = impl_->peaks[channel];
+    levels[channel].sum_of_squares = impl_->sums_of_squares[channel];
+  }
+  return levels;
+}
+
+void File::set_mix_matrix(const std::vector<std::vector<float>>& matrix) {
+  impl_->mix_rows = matrix;
+}
+
+std::vector<std::vector<float>> DownmixMatrix(uint16_t channel_number,
+                                              uint16_t output_channel_number) {
+  // -3 dB
+  const float kHalfPower = 0.70710678f;
+  std::vector<std::vector<float>> stereo;
+  switch (channel_number) {
+    case 1:
+      stereo = {{1.f}, {1.f}};
+      break;
+    case 2:
+      stereo = {{1.f, 0.f}, {0.f, 1.f}};
+      break;
+    case 6:
+      // L R C LFE Ls Rs
+      stereo = {{1.f, 0.f, kHalfPower, 0.f, kHalfPower, 0.f},
+                {0.f, 1.f, kHalfPower, 0.f, 0.f, kHalfPower}};
+      break;
+    case 8:
+      // L R C LFE Lb Rb Ls Rs
+      stereo = {
+          {1.f, 0.f, kHalfPower, 0.f, kHalfPower, 0.f, kHalfPower, 0.f},
+          {0.f, 1.f, kHalfPower, 0.f, 0.f, kHalfPower, 0.f, kHalfPower}};
+      break;
+    default:
+      return {};
+  }
+  if (output_channel_number == 2) {
+    return stereo;
+  }
+  if (output_channel_number != 1) {
+    return {};
+  }
+  std::vector<float> mono(channel_number);
+  for (size_t channel = 0; channel < mono.size(); channel++) {
+    mono[channel] = (stereo[0][channel] + stereo[1][channel]) / 2.f;
+  }
+  return {mono};
+}
+
+Error File::WriteChecksum() {
+  // in the byte order of the file, like its sizes
+  auto checksum =
+      internal::ToFileOrder(impl_->checksum, impl_->big_endian());
+  std::vector<char> content(sizeof(checksum));
+  memcpy(content.data(), &checksum, sizeof(checksum));
+  return WriteChunk(internal::kChecksumChunkId, content);
+}
+
+Error File::VerifyChecksum() {
+  std::vector<char> content;
+  auto error = ReadChunk(internal::kChecksumChunkId, &content);
+  if (error != kNoError) {
+    return error;
+  }
+  uint32_t stored_checksum;
+  if (content.size() != sizeof(stored_checksum)) {
+    return kInvalidFormat;
+  }
+  memcpy(&stored_checksum, content.data(), sizeof(stored_checksum));
+  stored_checksum =
+      internal::FromFileOrder(stored_checksum, impl_->big_endian());
+  return stored_checksum == impl_->checksum ? kNoError : kInvalidChecksum;
+}
+
+Error File::ReadChunk(BroadcastExtension* output) {
+  std::vector<char> content;
+  auto error = ReadChunk("bext", &content);
+  if (error != kNoError) {
+    return error;
+  }
+  return ParseBroadcastExtension(content, output);
+}
+
+Error File::WriteChunk(const BroadcastExtension& extension) {
+  return WriteChunk("bext", SerializeBroadcastExtension(extension));
+}
+
+Error File::ReadRegionIndex(std::vector<Region>* output) {
+  auto error = impl_->LoadRegions();
+  if (error != kNoError) {
+    return error;
+  }
+  *output = impl_->regions;
+  return kNoError;
+}
+
+Error File::ReadRegion(uint32_t id, std::vector<float>* output) {
+  auto error = impl_->LoadRegions();
+  if (error != kNoError) {
+    return error;
+  }
+  auto region = impl_->FindRegion(id);
+  if (region == nullptr) {
+    return kChunkNotFound;
+  }
+  if (Tell() != region->frame_index) {
+    error = Seek(region->frame_index);
+    if (error != kNoError) {
+      return error;
     }
   }
+  return Read(region->frame_number, output);
+}
 
-  // update header to show the right data size
-  impl_->WriteHeader(current_data_size + data.size());
+Error File::ReadRegions(const std::vector<uint32_t>& ids,
+                        std::vector<std::vector<float>>* output) {
+  auto error = impl_->LoadRegions();
+  if (error != kNoError) {
+    return error;
+  }
+  // regions to read with their index in output, in file order
+  std::vector<std::pair<const Region*, size_t>> requested;
+  for (size_t idx = 0; idx < ids.size(); idx++) {
+    auto region = impl_->FindRegion(ids[idx]);
+    if (region == nullptr) {
+      return kChunkNotFound;
+    }
+    requested.push_back(std::make_pair(region, idx));
+  }
+  std::stable_sort(requested.begin(), requested.end(),
+                   [](const std::pair<const Region*, size_t>& lhs,
+                      const std::pair<const Region*, size_t>& rhs) {
+                     return lhs.first->frame_index < rhs.first->frame_index;
+                   });
 
+  output->resize(ids.size());
+  size_t begin = 0;
+  while (begin < requested.size()) {
+    // span of the regions overlapping the first one, directly or through
+    // each other
+    auto span_start = requested[begin].first->frame_index;
+    auto span_end = span_start + requested[begin].first->frame_number;
+    auto end = begin + 1;
+    while (end < requested.size() &&
+           requested[end].first->frame_index < span_end) {
+      span_end = std::max(span_end, requested[end].first->frame_index +
+                                        requested[end].first->frame_number);
+      end++;
+    }
+    // regions following each other are read without seeking
+    if (Tell() != span_start) {
+      error = Seek(span_start);
+      if (error != kNoError) {
+        return error;
+      }
+    }
+    if (end == begin + 1) {
+      error = Read(span_end - span_start, &(*output)[requested[begin].second]);
+      if (error != kNoError) {
+        return error;
+      }
+      begin = end;
+      continue;
+    }
+    // shared frames are decoded once, then copied to each region
+    auto& frames = impl_->region_buffer;
+    error = Read(span_end - span_start, &frames);
+    if (error != kNoError) {
+      return error;
+    }
+    auto channel_number = frames.size() / (span_end - span_start);
+    for (; begin < end; begin++) {
+      auto region = requested[begin].first;
+      auto first = frames.begin() +
+                   (region->frame_index - span_start) * channel_number;
+      (*output)[requested[begin].second].assign(
+          first, first + region->frame_number * channel_number);
+    }
+  }
   return kNoError;
 }
 
 Error File::Seek(uint64_t frame_index) {
-  if (!impl_->ostream.is_open() && !impl_->istream.is_open()) {
+  if (!impl_->is_open()) {
     return kNotOpen;
   }
   if (frame_index > frame_number()) {
@@ -364,7 +1670,7 @@ Error File::Seek(uint64_t frame_index) {
 }
 
 uint64_t File::Tell() const {
-  if (!impl_->ostream.is_open() && !impl_->istream.is_open()) {
+  if (!impl_->is_open()) {
     return 0;
   }
 
@@ -398,6 +1704,10 @@ std::error_code make_error_code(Error err) {
       return std::make_error_code(std::errc::io_error);
     case kReadError:
       return std::make_error_code(std::errc::io_error);
+    case kChunkNotFound:
+      return std::make_error_code(std::errc::invalid_argument);
+    case kInvalidChecksum:
+      return std::make_error_code(std::errc::bad_message);
     default:
       return std::error_code();
   }
@@ -427,6 +1737,147 @@ void File::Open(const std::string& path, OpenMode mode, std::error_code& err) {
   err = make_error_code(wave_error);
 }
 
+Error File::ReadAsync(uint64_t frame_number, IOBackend* backend,
+                      std::function<void(Error, std::vector<float>)> callback) {
+  if (!impl_->can_read()) {
+    return kNotOpen;
+  }
+  if (backend == nullptr) {
+    backend = DefaultIOBackend();
+  }
+  auto requested_samples = frame_number * channel_number();
+  // check if we have enough data available
+  if (impl_->sample_number() <
+      requested_samples + impl_->current_sample_index()) {
+    return kInvalidFormat;
+  }
+  auto bits_per_sample = impl_->header.fmt.bits_per_sample;
+  if (!internal::IsSupportedBitsPerSample(bits_per_sample)) {
+    return kInvalidFormat;
+  }
+
+  // nothing to wait for on memory, samples are decoded like below
+  if (impl_->path.empty()) {
+    std::vector<char> bytes(requested_samples * (bits_per_sample / 8));
+    if (impl_->stream->Read(bytes.data(), bytes.size()) != bytes.size()) {
+      return kReadError;
+    }
+    std::vector<float> output(requested_samples);
+    internal::Decode(bytes.data(), bits_per_sample, requested_samples,
+                     output.data(), impl_->big_endian());
+    callback(kNoError, std::move(output));
+    return kNoError;
+  }
+
+  if (impl_->backend != backend) {
+    if (impl_->backend != nullptr) {
+      impl_->backend->Close(impl_->backend_handle);
+    }
+    impl_->backend = backend;
+    impl_->backend_handle = backend->Open(impl_->path);
+  }
+  if (impl_->backend_handle < 0) {
+    impl_->backend = nullptr;
+    return kFailedToOpen;
+  }
+
+  // submit the read and move forward
+  auto bytes_per_sample = bits_per_sample / 8;
+  uint64_t offset = impl_->stream->Tell();
+  uint64_t byte_count = requested_samples * bytes_per_sample;
+  impl_->set_current_sample_index(impl_->current_sample_index() +
+                                  requested_samples);
+
+  auto buffer = std::make_shared<std::vector<char>>(byte_count);
+  auto big_endian = impl_->big_endian();
+  backend->Read(impl_->backend_handle, offset, buffer->data(), byte_count,
+                [buffer, bits_per_sample, requested_samples, big_endian,
+                 callback](int64_t result) {
+                  std::vector<float> output;
+                  if (result < 0 ||
+                      static_cast<uint64_t>(result) != buffer->size()) {
+                    callback(kReadError, std::move(output));
+                    return;
+                  }
+                  output.resize(requested_samples);
+                  internal::Decode(buffer->data(), bits_per_sample,
+                                   requested_samples, output.data(),
+                                   big_endian);
+                  callback(kNoError, std::move(output));
+                });
+  return kNoError;
+}
+
+std::future<std::vector<float>> File::ReadAsync(uint64_t frame_number,
+                                                IOBackend* backend) {
+  auto promise = std::make_shared<std::promise<std::vector<float>>>();
+  auto error = ReadAsync(
+      frame_number, backend,
+      [promise](Error error, std::vector<float> content) {
+        if (error != kNoError) {
+          promise->set_exception(std::make_exception_ptr(
+              std::system_error(make_error_code(error))));
+          return;
+        }
+        promise->set_value(std::move(content));
+      });
+  if (error != kNoError) {
+    promise->set_exception(
+        std::make_exception_ptr(std::system_error(make_error_code(error))));
+  }
+  return promise->get_future();
+}
+
+Error File::WriteAsync(std::vector<float> data,
+                       std::function<void(Error)> callback, bool clip) {
+  if (!impl_->can_write()) {
+    return kNotOpen;
+  }
+  if (impl_->writer == nullptr) {
+    impl_->writer.reset(new ThreadPool(1));
+  }
+  // tasks have to be copyable, data is moved to a shared vector instead
+  auto shared_data = std::make_shared<std::vector<float>>(std::move(data));
+  auto impl = impl_.get();
+  impl_->writer->Schedule([impl, shared_data, callback, clip]() {
+    callback(impl->Write(*shared_data, internal::NoEncrypt, clip));
+  });
+  return kNoError;
+}
+
+std::future<void> File::WriteAsync(std::vector<float> data, bool clip) {
+  auto promise = std::make_shared<std::promise<void>>();
+  auto error = WriteAsync(std::move(data),
+                          [promise](Error error) {
+                            if (error != kNoError) {
+                              promise->set_exception(std::make_exception_ptr(
+                                  std::system_error(make_error_code(error))));
+                              return;
+                            }
+                            promise->set_value();
+                          },
+                          clip);
+  if (error != kNoError) {
+    promise->set_exception(
+        std::make_exception_ptr(std::system_error(make_error_code(error))));
+  }
+  return promise->get_future();
+}
+
 #endif  // __cplusplus > 199711L
 
+// typed Read and Write are only provided for these types
+template Error File::Read<int16_t>(std::vector<int16_t>*);
+template Error File::Read<int32_t>(std::vector<int32_t>*);
+template Error File::Read<float>(std::vector<float>*);
+template Error File::Read<double>(std::vector<double>*);
+template Error File::Read<int16_t>(uint64_t, std::vector<int16_t>*);
+template Error File::Read<int32_t>(uint64_t, std::vector<int32_t>*);
+template Error File::Read<float>(uint64_t, std::vector<float>*);
+template Error File::Read<double>(uint64_t, std::vector<double>*);
+template Error File::Write<int16_t>(const std::vector<int16_t>&, bool);
+template Error File::Write<int32_t>(const std::vector<int32_t>&, bool);
+template Error File::Write<float>(const std::vector<float>&, bool);
+template Error File::Write<double>(const std::vector<double>&, bool);
+
 }  // namespace wave
@@ -6,17 +6,56 @@
 #include <vector>
 
 #if __cplusplus > 199711L
+#include <functional>
+#include <future>
 #include <system_error>
 #include <memory>
 #endif  // __cplusplus > 199711L
 
+#ifdef __cpp_impl_coroutine
+#include <atomic>
+#include <coroutine>
+#endif  // __cpp_impl_coroutine
+
 #include <stdint.h>
 
+#include "wave/chunk.h"
 #include "wave/error.h"
 
 namespace wave {
 
-enum OpenMode { kIn, kOut };
+// kUpdate opens an existing file to read it and edit its chunks in place
+// kAppend opens an existing file to write samples after the existing ones
+enum OpenMode { kIn, kOut, kUpdate, kAppend };
+
+// Noise added by File::Write when it quantizes float and double samples to
+// 8 or 16 bits. kTPDFDither adds triangular noise of up to 1 LSB, which
+// turns quantization distortion into constant white noise.
+// kNoiseShapedDither also feeds the quantization error of each channel back
+// into its next sample, which moves the noise to high frequencies.
+enum Dither { kNoDither, kTPDFDither, kNoiseShapedDither };
+
+class IOBackend;
+
+/**
+ * @brief Levels of a channel, see File::set_levels_enabled
+ */
+struct ChannelLevels {
+  // largest absolute value
+  float peak;
+  double sum_of_squares;
+};
+
+/**
+ * @brief Standard downmix matrix of 1, 2, 6 (5.1) or 8 (7.1) channels, in the
+ * WAVE channel order, to mono or stereo, see File::set_mix_matrix. Center
+ * and surround channels are mixed at -3 dB and LFE is left out, as in
+ * ITU-R BS.775. Mono is the average of the stereo channels.
+ * @return an empty matrix if there is no standard downmix between the given
+ * channel numbers.
+ */
+std::vector<std::vector<float>> DownmixMatrix(uint16_t channel_number,
+                                              uint16_t output_channel_number);
 
 class File {
  public:
@@ -25,9 +64,55 @@ class File {
 
   /**
    * @brief Open wave file at given path
+   * @note: In kAppend mode, the existing file is kept and the position is set
+   * at the end of its samples.
    */
   Error Open(const std::string& path, OpenMode mode);
 
+  /**
+   * @brief Open wave data held in memory, in kIn mode.
+   * @note: data is decoded straight from the given region. It is not copied
+   * and has to outlive the File.
+   */
+  Error OpenBuffer(const void* data, size_t size);
+
+  /**
+   * @brief Open a growable memory buffer instead of a file.
+   * In kOut mode, the buffer is cleared and receives the whole wave file.
+   * @note: the buffer has to outlive the File.
+   */
+  Error OpenBuffer(std::vector<char>* buffer, OpenMode mode);
+
+  /**
+   * @brief Open a file in kOut mode, bypassing the page cache (O_DIRECT on
+   * Linux). Samples are written by large aligned blocks, the unaligned tail
+   * and the header are written when the file gets closed.
+   * @note: Where not supported, the file is opened like Open does.
+   */
+  Error OpenDirect(const std::string& path);
+
+  /**
+   * @brief Close the current file and open the one at given path.
+   * @note: Internal streams and buffers are kept, which makes it cheaper than
+   * constructing a new File for each file when processing many small files.
+   */
+  Error Reopen(const std::string& path, OpenMode mode);
+
+  /**
+   * @brief Close the current file, once its headers and the chunks given to
+   * WriteChunk are written. The format is kept.
+   * @note: The destructor, Reopen and Reset close the file too but can't
+   * report errors, call Close to know whether the file was entirely written.
+   * @return the first error met, or kNoError if the file wasn't open
+   */
+  Error Close();
+
+  /**
+   * @brief Close the current file and restore the default format.
+   * Internal buffers are kept for the next Open.
+   */
+  void Reset();
+
   /**
    * @brief Read the entire content of file.
    * @note: File has to be opened in kOut mode or kNotOpen will be returned
@@ -50,9 +135,18 @@ class File {
   Error Read(uint64_t frame_number, void (*decrypt)(char* data, size_t size),
              std::vector<float>* output);
 
+  /**
+   * @brief Read the given number of frames into memory owned by the caller,
+   * which must have room for frame_number frames of the channels Read
+   * outputs (the rows of the mix matrix when one is set).
+   */
+  Error Read(uint64_t frame_number, float* output);
+
   /**
    * @brief Write the given data
    * @note: File has to be opened in kIn mode or kNotOpen will be returned.
+   * In kAppend mode, the format has to match the one of the file or
+   * kInvalidFormat will be returned.
    * @param clip : if true, hard-clip (force value between -1. and 1.) before writing, 
    * else leave data intact. default to false
    */
@@ -67,6 +161,172 @@ class File {
   Error Write(const std::vector<float>& data,
               void (*encrypt)(char* data, size_t size), bool clip = false);
   
+  /**
+   * @brief Read straight to int16_t, int32_t, float or double samples, with
+   * no intermediate conversion. Integer samples keep the most significant
+   * bits of the file samples, floating point samples are in [-1, 1].
+   * @note: File has to be opened in kIn mode or kNotOpen will be returned.
+   * If file is too small, kInvalidFormat is returned
+   */
+  template <typename T>
+  Error Read(std::vector<T>* output);
+  template <typename T>
+  Error Read(uint64_t frame_number, std::vector<T>* output);
+
+  /**
+   * @brief Write int16_t, int32_t, float or double samples, with no
+   * intermediate conversion.
+   * @param clip : only applies to floating point samples
+   */
+  template <typename T>
+  Error Write(const std::vector<T>& data, bool clip = false);
+
+  /**
+   * @brief Read the given number of frames as stored in the file, without
+   * any conversion. Bytes of each sample are given to decrypt if set.
+   * @note: File has to be opened in kIn mode or kNotOpen will be returned.
+   * If file is too small, kInvalidFormat is returned
+   */
+  Error ReadRaw(uint64_t frame_number, std::vector<char>* output);
+  Error ReadRaw(uint64_t frame_number, void (*decrypt)(char* data, size_t size),
+                std::vector<char>* output);
+
+  /**
+   * @brief Write samples already in the format of the file, as given by
+   * ReadRaw on a file of the same format. Bytes of each sample are given to
+   * encrypt if set.
+   * @note: File has to be opened in kOut or kAppend mode or kNotOpen will be
+   * returned. data has to hold whole frames or kInvalidFormat is returned.
+   */
+  Error WriteRaw(const std::vector<char>& data);
+  Error WriteRaw(const std::vector<char>& data,
+                 void (*encrypt)(char* data, size_t size));
+
+  /**
+   * @brief IDs of the chunks other than RIFF, fmt, data and padding, in file
+   * order
+   */
+  std::vector<std::string> chunk_ids() const;
+
+  /**
+   * @brief Read the content of the first chunk with given ID.
+   * @note: kChunkNotFound is returned if the file has no such chunk.
+   */
+  Error ReadChunk(const std::string& id, std::vector<char>* content);
+
+  /**
+   * @brief Add or replace a chunk other than RIFF, fmt and data.
+   * In kOut and kAppend mode, chunks are written after the samples when the
+   * file gets closed. Chunks following the samples of a file opened in
+   * kAppend mode are moved after the new samples the same way.
+   * In kUpdate mode, the chunk is rewritten in place if it fits in its
+   * current space and the padding following it. Otherwise, it goes to
+   * some padding large enough or to the end of the file. Samples are never
+   * moved or rewritten.
+   */
+  Error WriteChunk(const std::string& id, const std::vector<char>& content);
+
+  /**
+   * @brief Typed access to the broadcast extension ("bext") chunk
+   */
+  Error ReadChunk(BroadcastExtension* output);
+  Error WriteChunk(const BroadcastExtension& extension);
+
+  /**
+   * @brief Regions defined by the cue points of the file, see Region, sorted
+   * by first frame. Cue points and their labels are parsed on first use
+   * only, by this or the region reads below.
+   * @note: kChunkNotFound is returned if the file has no "cue " chunk.
+   */
+  Error ReadRegionIndex(std::vector<Region>* output);
+
+  /**
+   * @brief Read the frames of the region with the given cue point id. The
+   * file is left at the end of the region.
+   * @note: kChunkNotFound is returned if there is no such region.
+   */
+  Error ReadRegion(uint32_t id, std::vector<float>* output);
+
+  /**
+   * @brief Read the frames of several regions, output has the frames of
+   * each id in the same order. Regions are read in file order, those
+   * following each other without seeking and those overlapping by decoding
+   * their frames once. The file is left at the end of the last region read.
+   * @note: kChunkNotFound is returned if one of the regions doesn't exist.
+   */
+  Error ReadRegions(const std::vector<uint32_t>& ids,
+                    std::vector<std::vector<float>>* output);
+
+  /**
+   * @brief Compute the CRC32C of the samples, as stored in the file, while
+   * Read, Write, ReadRaw and WriteRaw go through them. Disabled by default.
+   * @note: Enabling it resets checksum() to 0.
+   */
+  void set_checksum_enabled(bool enabled);
+
+  /**
+   * @brief CRC32C of the samples read or written since the file was opened,
+   * in that order. Once all the samples were read or written from the first
+   * to the last, it is the checksum of the data chunk.
+   */
+  uint32_t checksum() const;
+
+  /**
+   * @brief Store checksum() in a "crc " chunk, see WriteChunk
+   */
+  Error WriteChecksum();
+
+  /**
+   * @brief Compare checksum() to the one stored by WriteChecksum.
+   * @note: kChunkNotFound is returned if the file has no checksum, and
+   * kInvalidChecksum if they differ.
+   */
+  Error VerifyChecksum();
+
+  /**
+   * @brief Multiply the samples by gain while Read decodes them and before
+   * Write encodes them, in the same pass. The second version sets a gain for
+   * each channel, Read and Write return kInvalidFormat if their number
+   * doesn't match the channel number.
+   * @note: Only applies to float and double samples, it is not reset on Open.
+   */
+  void set_gain(float gain);
+  void set_gain(const std::vector<float>& channel_gains);
+
+  /**
+   * @brief Dither used by Write from now on, see Dither. Samples are rounded
+   * to the nearest value instead of being truncated. The noise of each
+   * sample is drawn from seed and its position in file, so a file written
+   * twice with the same seed is the same, however it is split between
+   * writes. None by default.
+   */
+  void set_dither(Dither dither, uint64_t seed = 0);
+
+  /**
+   * @brief Track the levels of each channel while Read and Write go through
+   * float and double samples, after the gain is applied. Disabled by default.
+   * @note: Enabling it resets the levels.
+   */
+  void set_levels_enabled(bool enabled);
+
+  /**
+   * @brief Levels of each channel since they were enabled. Empty until
+   * samples were read or written.
+   */
+  std::vector<ChannelLevels> levels() const;
+
+  /**
+   * @brief Mix the channels of the file while Read decodes them, so that
+   * Read only outputs the mixed channels. matrix has a row of channel_number()
+   * coefficients for each output channel, see DownmixMatrix for the standard
+   * ones. An empty matrix disables mixing.
+   * @note: Only applies to float and double samples, Read returns
+   * kInvalidFormat for other types or if a row doesn't match the channel
+   * number. Gain and levels apply to the channels of the file, before they
+   * are mixed. ReadAsync is not mixed, see ReadAsync.
+   */
+  void set_mix_matrix(const std::vector<std::vector<float>>& matrix);
+
   /**
    * Move to the given frame in the file
    */
@@ -96,6 +356,39 @@ class File {
    */
   void Write(const std::vector<float>& data, std::error_code& err, bool clip = false);
   void Open(const std::string& path, OpenMode mode, std::error_code& err);
+
+  /**
+   * @brief Read the given number of frames through an asynchronous I/O
+   * backend, or the library one if null. Position moves forward right away
+   * so that successive calls read successive blocks. callback receives the
+   * decoded frames from a backend thread.
+   * @note: File has to be opened in kIn mode or kNotOpen will be returned.
+   * Files opened on a buffer are read synchronously. Frames are decoded as
+   * stored: reads complete in any order, so gain, levels, the mix matrix
+   * and the checksum only apply to Read.
+   */
+  Error ReadAsync(uint64_t frame_number, IOBackend* backend,
+                  std::function<void(Error, std::vector<float>)> callback);
+
+  /**
+   * @brief Read the given number of frames like above.
+   * @return the decoded frames. On error, the future holds a
+   * std::system_error with the std::error_code of the error.
+   */
+  std::future<std::vector<float>> ReadAsync(uint64_t frame_number,
+                                            IOBackend* backend = nullptr);
+
+  /**
+   * @brief Write the given data from a thread owned by the File. data is moved
+   * there, writes run in the order they were submitted. callback receives the
+   * error of the write from that thread.
+   * @note: File has to be opened in kOut or kAppend mode or kNotOpen will be
+   * returned. The File must not be used otherwise until the writes are done.
+   * Closing the File waits for them.
+   */
+  Error WriteAsync(std::vector<float> data, std::function<void(Error)> callback,
+                   bool clip = false);
+  std::future<void> WriteAsync(std::vector<float> data, bool clip = false);
 #endif  // __cplusplus > 199711L
 
   uint16_t channel_number() const;
@@ -107,7 +400,53 @@ class File {
   uint16_t bits_per_sample() const;
   void set_bits_per_sample(uint16_t bits_per_sample);
 
+  /**
+   * @brief Whether sizes and samples are stored big-endian, in a RIFX file
+   * rather than a RIFF one. Files are read in either order.
+   * @note: Set it in kOut mode before the first Write.
+   */
+  bool big_endian() const;
+  void set_big_endian(bool big_endian);
+
   uint64_t frame_number() const;
+
+  /**
+   * @brief Number of frames expected to be written. When set before the first
+   * Write, storage for the whole file is reserved at once (where supported),
+   * which avoids fragmentation of long recordings. In kOut mode, the header
+   * is written once for these frames instead of after each Write, and again
+   * on Close only if another number of frames was written.
+   */
+  void set_expected_frame_number(uint64_t frame_number);
+
+  /**
+   * @brief Write samples at the given frame, without moving the position
+   * used by Write. Calls writing disjoint frames can run from several
+   * threads at once, to render a file in parallel. Files on disk are then
+   * written with positional writes where supported, other storages one call
+   * at a time.
+   * @note: File has to be opened in kOut mode, or kNotOpen is returned, and
+   * the frames have to be within the expected frame number, or
+   * kInvalidFormat is returned. Gain, levels and checksum don't apply, and
+   * noise shaped dither falls back to TPDF dither. Other methods of File
+   * must not run during the calls.
+   */
+  Error WriteAt(uint64_t frame_index, const std::vector<float>& data,
+                bool clip = false);
+
+  /**
+   * @brief Read frame_number frames at the given frame as stored in the file,
+   * like ReadRaw, without moving the position used by Read. Calls can run
+   * from several threads at once, to serve random access reads of a shared
+   * file. Files on disk and memory buffers are then read with positional
+   * reads where supported, other storages one call at a time.
+   * @note: File has to be opened in kIn mode or kNotOpen is returned.
+   * kInvalidSeek is returned if frame_index is beyond the end of the file,
+   * kInvalidFormat if the frames are. Checksum and decryption don't apply.
+   * Other methods of File changing it must not run during the calls.
+   */
+  Error ReadRawAt(uint64_t frame_index, uint64_t frame_number,
+                  std::vector<char>* output);
   
  private:
   class Impl;
@@ -117,6 +456,95 @@ class File {
   Impl* impl_;
 #endif //  __cplusplus <= 201103L
 };
+
+#if __cplusplus > 199711L
+std::error_code make_error_code(Error err);
+#endif  // __cplusplus > 199711L
+
+#ifdef __cpp_impl_coroutine
+/**
+ * @brief co_await-able versions of File::ReadAsync and File::WriteAsync, for
+ * C++20 code. The coroutine is resumed from the thread completing the I/O.
+ * Errors are thrown as std::system_error.
+ */
+class ReadAwaitable {
+ public:
+  ReadAwaitable(File* file, uint64_t frame_number,
+                IOBackend* backend = nullptr)
+      : file_(file), frame_number_(frame_number), backend_(backend),
+        error_(kNoError), done_(false) {}
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) {
+    auto error = file_->ReadAsync(
+        frame_number_, backend_,
+        [this, handle](Error error, std::vector<float> content) {
+          error_ = error;
+          content_ = std::move(content);
+          // resume unless await_suspend didn't return yet
+          if (done_.exchange(true)) {
+            handle.resume();
+          }
+        });
+    if (error != kNoError) {
+      error_ = error;
+      return false;
+    }
+    return !done_.exchange(true);
+  }
+  std::vector<float> await_resume() {
+    if (error_ != kNoError) {
+      throw std::system_error(make_error_code(error_));
+    }
+    return std::move(content_);
+  }
+
+ private:
+  File* file_;
+  uint64_t frame_number_;
+  IOBackend* backend_;
+  Error error_;
+  std::vector<float> content_;
+  std::atomic<bool> done_;
+};
+
+class WriteAwaitable {
+ public:
+  WriteAwaitable(File* file, std::vector<float> data, bool clip = false)
+      : file_(file), data_(std::move(data)), clip_(clip), error_(kNoError),
+        done_(false) {}
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) {
+    auto error = file_->WriteAsync(
+        std::move(data_),
+        [this, handle](Error error) {
+          error_ = error;
+          if (done_.exchange(true)) {
+            handle.resume();
+          }
+        },
+        clip_);
+    if (error != kNoError) {
+      error_ = error;
+      return false;
+    }
+    return !done_.exchange(true);
+  }
+  void await_resume() {
+    if (error_ != kNoError) {
+      throw std::system_error(make_error_code(error_));
+    }
+  }
+
+ private:
+  File* file_;
+  std::vector<float> data_;
+  bool clip_;
+  Error error_;
+  std::atomic<bool> done_;
+};
+#endif  // __cpp_impl_coroutine
 }  // namespace wave
 
 #endif  // WAVE_WAVE_FILE_H_
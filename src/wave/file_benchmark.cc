@@ -0,0 +1,189 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "wave/crop_sampler.h"
+#include "wave/file.h"
+#include "wave/io_backend.h"
+#include "wave/probe.h"
+
+namespace {
+
+const uint32_t kSampleRate = 44100;
+const uint16_t kChannelNumber = 2;
+const uint64_t kClipFrameNumber = 2 * kSampleRate;
+
+std::string ClipPath(const std::string& directory, int index) {
+  return directory + "/wave_benchmark_" + std::to_string(index) + ".wav";
+}
+
+bool WriteClips(const std::string& directory, int clip_number) {
+  std::vector<float> content(kClipFrameNumber * kChannelNumber);
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    content[idx] = static_cast<float>(idx % 200) / 100.f - 1.f;
+  }
+  wave::File file;
+  for (int idx = 0; idx < clip_number; idx++) {
+    if (file.Reopen(ClipPath(directory, idx), wave::kOut) != wave::kNoError) {
+      return false;
+    }
+    file.set_sample_rate(kSampleRate);
+    file.set_channel_number(kChannelNumber);
+    if (file.Write(content) != wave::kNoError) {
+      return false;
+    }
+  }
+  file.Reset();
+  return true;
+}
+
+template <typename Function>
+void Report(const std::string& name, int clip_number, Function function,
+            const std::string& unit = "files") {
+  auto start = std::chrono::steady_clock::now();
+  if (!function()) {
+    std::cout << name << ": failed" << std::endl;
+    return;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << clip_number / elapsed.count() << " " << unit
+            << " per second" << std::endl;
+}
+
+// Submit the read of every file at once and wait for all of them
+bool ReadAsync(const std::string& directory, int clip_number,
+               wave::IOBackend* backend) {
+  std::vector<wave::File> files(clip_number);
+  std::mutex mutex;
+  std::condition_variable condition;
+  int done = 0;
+  bool success = true;
+  for (int idx = 0; idx < clip_number; idx++) {
+    auto& file = files[idx];
+    if (file.Open(ClipPath(directory, idx), wave::kIn) != wave::kNoError) {
+      return false;
+    }
+    auto error = file.ReadAsync(
+        file.frame_number(), backend,
+        [&](wave::Error error, std::vector<float> content) {
+          std::lock_guard<std::mutex> lock(mutex);
+          success = success && error == wave::kNoError;
+          done++;
+          condition.notify_one();
+        });
+    if (error != wave::kNoError) {
+      return false;
+    }
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  condition.wait(lock, [&]() { return done == clip_number; });
+  return success;
+}
+
+}  // namespace
+
+// Measure how many short files can be opened, read and closed per second,
+// either with a new File for each one, with a single reused File or with
+// asynchronous reads of all the files at once. Probing metadata only and
+// batches of random one second crops are measured as well.
+// usage: wave_file_benchmark [directory] [file number]
+int main(int argc, char** argv) {
+  std::string directory = argc > 1 ? argv[1] : ".";
+  int clip_number = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+  if (!WriteClips(directory, clip_number)) {
+    std::cout << "Failed to write clips in " << directory << std::endl;
+    return 1;
+  }
+
+  std::vector<float> content;
+  Report("new File per file", clip_number, [&]() {
+    for (int idx = 0; idx < clip_number; idx++) {
+      wave::File file;
+      if (file.Open(ClipPath(directory, idx), wave::kIn) != wave::kNoError ||
+          file.Read(&content) != wave::kNoError) {
+        return false;
+      }
+    }
+    return true;
+  });
+
+  Report("reused File", clip_number, [&]() {
+    wave::File file;
+    for (int idx = 0; idx < clip_number; idx++) {
+      if (file.Reopen(ClipPath(directory, idx), wave::kIn) !=
+              wave::kNoError ||
+          file.Read(&content) != wave::kNoError) {
+        return false;
+      }
+    }
+    return true;
+  });
+
+  auto thread_pool_backend = wave::MakeThreadPoolBackend();
+  Report("async reads, thread pool backend", clip_number, [&]() {
+    return ReadAsync(directory, clip_number, thread_pool_backend.get());
+  });
+
+  auto io_uring_backend = wave::MakeIOUringBackend();
+  if (io_uring_backend != nullptr) {
+    Report("async reads, io_uring backend", clip_number, [&]() {
+      return ReadAsync(directory, clip_number, io_uring_backend.get());
+    });
+  }
+
+  Report("probe", clip_number, [&]() {
+    wave::Metadata metadata;
+    for (int idx = 0; idx < clip_number; idx++) {
+      if (wave::Probe(ClipPath(directory, idx), &metadata) != wave::kNoError) {
+        return false;
+      }
+    }
+    return true;
+  });
+
+  Report("batch probe", clip_number, [&]() {
+    std::vector<std::string> paths;
+    for (int idx = 0; idx < clip_number; idx++) {
+      paths.push_back(ClipPath(directory, idx));
+    }
+    std::vector<wave::Metadata> metadata;
+    auto errors = wave::Probe(paths, &metadata);
+    for (auto error : errors) {
+      if (error != wave::kNoError) {
+        return false;
+      }
+    }
+    return true;
+  });
+
+  const size_t kBatchSize = 64;
+  const int kBatchNumber = 20;
+  wave::CropSampler sampler;
+  std::vector<std::string> paths;
+  for (int idx = 0; idx < clip_number; idx++) {
+    paths.push_back(ClipPath(directory, idx));
+  }
+  sampler.Open(paths, kSampleRate, kChannelNumber, kSampleRate);
+  Report("random crops, batches of 64", kBatchSize * kBatchNumber,
+         [&]() {
+           for (int batch = 0; batch < kBatchNumber; batch++) {
+             if (sampler.Sample(kBatchSize, &content) != wave::kNoError) {
+               return false;
+             }
+           }
+           return true;
+         },
+         "crops");
+
+  for (int idx = 0; idx < clip_number; idx++) {
+    std::remove(ClipPath(directory, idx).c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,169 @@
+#include "wave/file_pool.h"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "wave/codec.h"
+#include "wave/file.h"
+
+namespace wave {
+
+namespace {
+
+// A file of the pool, shared by the reads using it, which don't move its
+// position
+struct PooledFile {
+  File file;
+};
+
+}  // namespace
+
+class FilePool::Impl {
+ public:
+  explicit Impl(size_t max_open_file_number)
+      : max_open_file_number(std::max<size_t>(max_open_file_number, 1)) {
+    metrics.hit_number = 0;
+    metrics.miss_number = 0;
+    metrics.eviction_number = 0;
+    metrics.open_file_number = 0;
+  }
+
+  // The pooled file at path, opened if needed
+  Error Get(const std::string& path, std::shared_ptr<PooledFile>* output) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found = files.find(path);
+      if (found != files.end()) {
+        // most recently used first
+        recent_paths.splice(recent_paths.begin(), recent_paths,
+                            found->second.second);
+        metrics.hit_number++;
+        *output = found->second.first;
+        return kNoError;
+      }
+    }
+
+    // opened without the lock so that other files are still served
+    std::shared_ptr<PooledFile> opened(new PooledFile());
+    auto error = opened->file.Open(path, kIn);
+    if (error != kNoError) {
+      return error;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    metrics.miss_number++;
+    auto found = files.find(path);
+    if (found != files.end()) {
+      // opened by another thread in the meantime
+      *output = found->second.first;
+      return kNoError;
+    }
+    recent_paths.push_front(path);
+    files.insert(
+        std::make_pair(path, std::make_pair(opened, recent_paths.begin())));
+    while (files.size() > max_open_file_number) {
+      files.erase(recent_paths.back());
+      recent_paths.pop_back();
+      metrics.eviction_number++;
+    }
+    metrics.open_file_number = files.size();
+    *output = opened;
+    return kNoError;
+  }
+
+  static Error Read(PooledFile* pooled, uint64_t frame_index,
+                    uint64_t frame_number, float* output) {
+    // kept by each thread, reads are usually of the same size
+    thread_local std::vector<char> bytes;
+    // positional reads, threads reading the same file don't wait for each
+    // other
+    auto& file = pooled->file;
+    auto error = file.ReadRawAt(frame_index, frame_number, &bytes);
+    if (error != kNoError) {
+      return error;
+    }
+    auto bits_per_sample = file.bits_per_sample();
+    internal::Decode(bytes.data(), bits_per_sample,
+                     bytes.size() / (bits_per_sample / 8), output,
+                     file.big_endian());
+    return kNoError;
+  }
+
+  const size_t max_open_file_number;
+  mutable std::mutex mutex;
+  // paths from the most to the least recently used
+  std::list<std::string> recent_paths;
+  std::unordered_map<std::string,
+                     std::pair<std::shared_ptr<PooledFile>,
+                               std::list<std::string>::iterator>>
+      files;
+  FilePoolMetrics metrics;
+};
+
+FilePool::FilePool(size_t max_open_file_number)
+    : impl_(new Impl(max_open_file_number)) {}
+
+FilePool::~FilePool() = default;
+
+Error FilePool::Read(const std::string& path, uint64_t frame_index,
+                     uint64_t frame_number, std::vector<float>* output) {
+  std::shared_ptr<PooledFile> pooled;
+  auto error = impl_->Get(path, &pooled);
+  if (error != kNoError) {
+    return error;
+  }
+  output->resize(frame_number * pooled->file.channel_number());
+  return Impl::Read(pooled.get(), frame_index, frame_number, output->data());
+}
+
+Error FilePool::Read(const std::string& path, uint64_t frame_index,
+                     uint64_t frame_number, float* output) {
+  std::shared_ptr<PooledFile> pooled;
+  auto error = impl_->Get(path, &pooled);
+  if (error != kNoError) {
+    return error;
+  }
+  return Impl::Read(pooled.get(), frame_index, frame_number, output);
+}
+
+Error FilePool::Probe(const std::string& path, Metadata* output) {
+  std::shared_ptr<PooledFile> pooled;
+  auto error = impl_->Get(path, &pooled);
+  if (error != kNoError) {
+    return error;
+  }
+  // File only opens PCM files
+  const uint16_t kPCMFormat = 1;
+  const auto& file = pooled->file;
+  output->audio_format = kPCMFormat;
+  output->channel_number = file.channel_number();
+  output->sample_rate = file.sample_rate();
+  output->bits_per_sample = file.bits_per_sample();
+  output->frame_number = file.frame_number();
+  output->duration =
+      output->sample_rate == 0
+          ? 0.
+          : static_cast<double>(output->frame_number) / output->sample_rate;
+  return kNoError;
+}
+
+void FilePool::Clear() {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  impl_->files.clear();
+  impl_->recent_paths.clear();
+  impl_->metrics.open_file_number = 0;
+}
+
+FilePoolMetrics FilePool::metrics() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  return impl_->metrics;
+}
+
+size_t FilePool::max_open_file_number() const {
+  return impl_->max_open_file_number;
+}
+
+}  // namespace wave
@@ -0,0 +1,77 @@
+#ifndef WAVE_WAVE_FILE_POOL_H_
+#define WAVE_WAVE_FILE_POOL_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+#include "wave/probe.h"
+
+namespace wave {
+
+/**
+ * @brief Counters of a FilePool since it was made
+ */
+struct FilePoolMetrics {
+  // reads and probes served by a file already open
+  uint64_t hit_number;
+  // files opened
+  uint64_t miss_number;
+  // files closed to stay within the maximum number of open files
+  uint64_t eviction_number;
+  // files currently open
+  uint64_t open_file_number;
+};
+
+/**
+ * @brief Keep files open with their parsed headers for random access reads
+ * across many files. The least recently used file is closed when a new one
+ * has to be opened and the maximum number of open files is reached.
+ * All the methods can be called from several threads at once, also for the
+ * same file: the bytes of each read are fetched with positional reads (see
+ * File::ReadRawAt), which run at once on files on disk where supported.
+ */
+class FilePool {
+ public:
+  explicit FilePool(size_t max_open_file_number = 128);
+  ~FilePool();
+
+  /**
+   * @brief Read frame_number frames of the file at given path, starting at
+   * frame_index.
+   * @note: errors are the ones of File::Open and File::Read. A file being
+   * read when it gets evicted is closed once the read is done.
+   */
+  Error Read(const std::string& path, uint64_t frame_index,
+             uint64_t frame_number, std::vector<float>* output);
+
+  /**
+   * @brief Read into memory owned by the caller, which must have room for
+   * frame_number frames of the file
+   */
+  Error Read(const std::string& path, uint64_t frame_index,
+             uint64_t frame_number, float* output);
+
+  /**
+   * @brief Like wave::Probe, from the headers of the pooled file
+   */
+  Error Probe(const std::string& path, Metadata* output);
+
+  /**
+   * @brief Close all the files
+   */
+  void Clear();
+
+  FilePoolMetrics metrics() const;
+  size_t max_open_file_number() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_FILE_POOL_H_
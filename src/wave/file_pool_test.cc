@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+#include "wave/file_pool.h"
+#include "wave/test_files.h"
+
+const std::string gResourcePath(TEST_RESOURCES_PATH);
+
+#ifdef __linux__
+namespace {
+std::mutex gPreadMutex;
+std::condition_variable gPreadCondition;
+// whether a read waits for another one to start before reading
+bool gPreadWait = false;
+// reads in pread, and the most of them seen at once
+int gPreadNumber = 0;
+int gPreadMostNumber = 0;
+}  // namespace
+
+// Positional reads of the library go through here in the tests
+extern "C" ssize_t pread(int fd, void* data, size_t size, off_t offset) {
+  {
+    std::unique_lock<std::mutex> lock(gPreadMutex);
+    gPreadNumber++;
+    gPreadMostNumber = std::max(gPreadMostNumber, gPreadNumber);
+    gPreadCondition.notify_all();
+    if (gPreadWait) {
+      gPreadCondition.wait_for(lock, std::chrono::seconds(2),
+                               []() { return gPreadNumber > 1; });
+    }
+  }
+  auto result = syscall(SYS_pread64, fd, data, size, offset);
+  std::lock_guard<std::mutex> lock(gPreadMutex);
+  gPreadNumber--;
+  return result;
+}
+#endif  // __linux__
+
+TEST(FilePool, Read) {
+  using namespace wave;
+  const uint64_t kFrameNumber = 20000;
+  // files of different content and format
+  std::vector<std::string> paths;
+  std::vector<std::vector<float>> contents;
+  for (size_t idx = 0; idx < 4; idx++) {
+    uint16_t channel_number = idx % 2 + 1;
+    paths.push_back(gResourcePath + "/output-pool-" + std::to_string(idx) +
+                    ".wav");
+    contents.push_back(TestRamp(kFrameNumber * channel_number, idx));
+    ASSERT_EQ(WriteTestFile(paths.back(), channel_number, &contents.back(),
+                            idx % 3 == 0 ? 24 : 16, idx == 1),
+              kNoError);
+  }
+
+  FilePool pool(2);
+  ASSERT_EQ(pool.max_open_file_number(), 2);
+  Metadata metadata;
+  ASSERT_EQ(pool.Probe(paths[1], &metadata), kNoError);
+  ASSERT_EQ(metadata.channel_number, 2);
+  ASSERT_EQ(metadata.frame_number, kFrameNumber);
+
+  std::vector<float> output;
+  ASSERT_EQ(pool.Read(paths[1], 100, 1000, &output), kNoError);
+  ASSERT_EQ(output, std::vector<float>(contents[1].begin() + 200,
+                                       contents[1].begin() + 2200));
+  ASSERT_EQ(pool.Read(paths[0], 0, 10, &output), kNoError);
+  ASSERT_EQ(pool.Read(paths[2], 0, 10, &output), kNoError);
+  // least recently used was 1
+  ASSERT_EQ(pool.Read(paths[0], kFrameNumber - 10, 10, &output), kNoError);
+  ASSERT_EQ(output, std::vector<float>(contents[0].end() - 10,
+                                       contents[0].end()));
+  auto metrics = pool.metrics();
+  ASSERT_EQ(metrics.miss_number, 3);
+  ASSERT_EQ(metrics.hit_number, 2);
+  ASSERT_EQ(metrics.eviction_number, 1);
+  ASSERT_EQ(metrics.open_file_number, 2);
+
+  ASSERT_EQ(pool.Read(paths[0], kFrameNumber - 10, 11, &output),
+            kInvalidFormat);
+  ASSERT_EQ(pool.Read(gResourcePath + "/missing.wav", 0, 10, &output),
+            kFailedToOpen);
+  pool.Clear();
+  ASSERT_EQ(pool.metrics().open_file_number, 0);
+}
+
+TEST(FilePool, ConcurrentReads) {
+  using namespace wave;
+  const uint64_t kFrameNumber = 20000;
+  // files of different content and format
+  std::vector<std::string> paths;
+  std::vector<std::vector<float>> contents;
+  for (size_t idx = 0; idx < 6; idx++) {
+    uint16_t channel_number = idx % 2 + 1;
+    paths.push_back(gResourcePath + "/output-pool-" + std::to_string(idx) +
+                    ".wav");
+    contents.push_back(TestRamp(kFrameNumber * channel_number, idx));
+    ASSERT_EQ(WriteTestFile(paths.back(), channel_number, &contents.back(),
+                            idx % 3 == 0 ? 24 : 16, idx == 1),
+              kNoError);
+  }
+
+  // fewer files than paths, so that files get evicted while being read
+  FilePool pool(3);
+  const size_t kThreadNumber = 4;
+  const uint64_t kSegmentSize = 1000;
+  std::vector<size_t> failures(kThreadNumber, 0);
+  std::vector<std::thread> threads;
+  for (size_t thread = 0; thread < kThreadNumber; thread++) {
+    threads.emplace_back([&, thread]() {
+      std::vector<float> output;
+      for (size_t read = 0; read < 200; read++) {
+        auto idx = (read * 7 + thread) % paths.size();
+        auto frame_index = (read * 997 + thread * 131) %
+                           (kFrameNumber - kSegmentSize);
+        auto channel_number = idx % 2 + 1;
+        auto first =
+            contents[idx].begin() + frame_index * channel_number;
+        if (pool.Read(paths[idx], frame_index, kSegmentSize, &output) !=
+                kNoError ||
+            output != std::vector<float>(
+                          first, first + kSegmentSize * channel_number)) {
+          failures[thread]++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(failures, std::vector<size_t>(kThreadNumber, 0));
+  auto metrics = pool.metrics();
+  ASSERT_EQ(metrics.hit_number + metrics.miss_number, kThreadNumber * 200);
+  ASSERT_LE(metrics.open_file_number, 3);
+}
+
+#ifdef __linux__
+TEST(FilePool, OverlappingReads) {
+  using namespace wave;
+  auto path = gResourcePath + "/output-pool-overlap.wav";
+  auto content = TestRamp(20000, 0);
+  ASSERT_EQ(WriteTestFile(path, 1, &content), kNoError);
+  FilePool pool;
+  // opened first, the reads only read
+  std::vector<float> output;
+  ASSERT_EQ(pool.Read(path, 0, 10, &output), kNoError);
+  {
+    // each read waits in pread for the other one
+    std::lock_guard<std::mutex> lock(gPreadMutex);
+    gPreadWait = true;
+    gPreadMostNumber = 0;
+  }
+  std::vector<std::vector<float>> outputs(2);
+  std::vector<std::thread> threads;
+  for (size_t idx = 0; idx < outputs.size(); idx++) {
+    threads.emplace_back([&, idx]() {
+      pool.Read(path, idx * 1000, 1000, &outputs[idx]);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::lock_guard<std::mutex> lock(gPreadMutex);
+  gPreadWait = false;
+  // both threads were reading the file at once
+  ASSERT_EQ(gPreadMostNumber, 2);
+  for (size_t idx = 0; idx < outputs.size(); idx++) {
+    ASSERT_EQ(outputs[idx],
+              std::vector<float>(content.begin() + idx * 1000,
+                                 content.begin() + (idx + 1) * 1000));
+  }
+}
+#endif  // __linux__
@@ -1,10 +1,19 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <cstring>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
 
+#include "wave/crc32c.h"
 #include "wave/file.h"
+#include "wave/io_backend.h"
 
 const std::string gResourcePath(TEST_RESOURCES_PATH);
 
@@ -406,8 +415,1480 @@ TEST(Wave, ExtraHeaders) {
   write_file.Write(data);
 }
 
+void CheckReadAsync(wave::IOBackend* backend) {
+  using namespace wave;
+
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+
+  // submit every block at once then wait for all of them
+  File file;
+  file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  const uint64_t kBlockSize = 10000;
+  auto block_number = file.frame_number() / kBlockSize;
+  std::vector<std::vector<float>> blocks(block_number);
+  std::mutex mutex;
+  std::condition_variable condition;
+  size_t done = 0;
+  for (size_t idx = 0; idx < block_number; idx++) {
+    auto err = file.ReadAsync(
+        kBlockSize, backend, [&, idx](Error error, std::vector<float> block) {
+          EXPECT_EQ(error, kNoError);
+          std::lock_guard<std::mutex> lock(mutex);
+          blocks[idx] = std::move(block);
+          done++;
+          condition.notify_one();
+        });
+    ASSERT_EQ(err, kNoError);
+  }
+  ASSERT_EQ(file.Tell(), block_number * kBlockSize);
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&]() { return done == block_number; });
+  }
+
+  auto block_samples = kBlockSize * file.channel_number();
+  for (size_t idx = 0; idx < block_number; idx++) {
+    ASSERT_EQ(blocks[idx].size(), block_samples);
+    for (size_t sample_idx = 0; sample_idx < block_samples; sample_idx++) {
+      ASSERT_EQ(blocks[idx][sample_idx],
+                content[idx * block_samples + sample_idx]);
+    }
+  }
+  // not enough data left
+  ASSERT_EQ(file.ReadAsync(kBlockSize, backend,
+                           [](Error, std::vector<float>) {}),
+            kInvalidFormat);
+}
+
+// Reads in flight complete when their File gets closed, even when other
+// files are opened meanwhile
+void CheckReadAsyncClose(wave::IOBackend* backend) {
+  using namespace wave;
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+
+  const size_t kBlockNumber = 8;
+  auto block_frame_number = read_file.frame_number() / kBlockNumber;
+  auto block_samples = block_frame_number * read_file.channel_number();
+  std::vector<std::vector<float>> blocks(kBlockNumber);
+  std::mutex mutex;
+  std::condition_variable condition;
+  size_t done = 0;
+  {
+    File file;
+    file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+    for (size_t idx = 0; idx < kBlockNumber; idx++) {
+      auto err = file.ReadAsync(
+          block_frame_number, backend,
+          [&, idx](Error error, std::vector<float> block) {
+            EXPECT_EQ(error, kNoError);
+            std::lock_guard<std::mutex> lock(mutex);
+            blocks[idx] = std::move(block);
+            done++;
+            condition.notify_one();
+          });
+      ASSERT_EQ(err, kNoError);
+    }
+  }
+  // descriptors released by the closed File must not be reused by reads
+  // still in flight
+  std::vector<File> others(8);
+  for (auto& other : others) {
+    ASSERT_EQ(other.Open(gResourcePath + "/extra-header.wav", OpenMode::kIn),
+              kNoError);
+    ASSERT_EQ(other.ReadAsync(1, backend).get().size(),
+              other.channel_number());
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&]() { return done == kBlockNumber; });
+  }
+  for (size_t idx = 0; idx < kBlockNumber; idx++) {
+    ASSERT_EQ(blocks[idx],
+              std::vector<float>(content.begin() + idx * block_samples,
+                                 content.begin() + (idx + 1) * block_samples));
+  }
+}
+
+// reads on closed or unknown handles fail instead of reading whatever file
+// got the same descriptor
+void CheckReadClosedHandle(wave::IOBackend* backend) {
+  auto handle = backend->Open(gResourcePath + "/Untitled3.wav");
+  ASSERT_GE(handle, 0);
+  backend->Close(handle);
+  // takes the descriptor number of the closed handle, if it is one
+  auto other = fopen((gResourcePath + "/extra-header.wav").c_str(), "rb");
+  ASSERT_NE(other, nullptr);
+  char data[16];
+  for (auto closed : {handle, handle + 1000}) {
+    std::promise<int64_t> result;
+    backend->Read(closed, 0, data, sizeof(data),
+                  [&](int64_t read) { result.set_value(read); });
+    EXPECT_LT(result.get_future().get(), 0);
+  }
+  fclose(other);
+}
+
+TEST(Wave, ReadAsyncThreadPool) {
+  auto backend = wave::MakeThreadPoolBackend(2);
+  CheckReadAsync(backend.get());
+  CheckReadAsyncClose(backend.get());
+  CheckReadClosedHandle(backend.get());
+}
+
+TEST(Wave, ReadAsyncIOUring) {
+  auto backend = wave::MakeIOUringBackend();
+  if (backend == nullptr) {
+    std::cout << "io_uring is not available, skipping" << std::endl;
+    return;
+  }
+  CheckReadAsync(backend.get());
+  CheckReadAsyncClose(backend.get());
+  CheckReadClosedHandle(backend.get());
+}
+
+TEST(Wave, ReadAsyncDecodesAsStored) {
+  using namespace wave;
+  auto path = gResourcePath + "/Untitled3.wav";
+  File read_file;
+  read_file.Open(path, OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+  std::ifstream stream(path, std::ios::binary);
+  std::vector<char> buffer((std::istreambuf_iterator<char>(stream)),
+                           std::istreambuf_iterator<char>());
+
+  // files on disk and in memory give the same frames, without processing
+  File file, memory_file;
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_EQ(memory_file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  for (auto opened : {&file, &memory_file}) {
+    opened->set_gain(0.5f);
+    opened->set_mix_matrix(DownmixMatrix(2, 1));
+    opened->set_levels_enabled(true);
+    opened->set_checksum_enabled(true);
+    ASSERT_EQ(opened->ReadAsync(1000).get(),
+              std::vector<float>(content.begin(), content.begin() + 2000));
+    ASSERT_EQ(opened->checksum(), 0);
+    ASSERT_EQ(opened->Tell(), 1000);
+  }
+}
+
+TEST(Wave, Futures) {
+  using namespace wave;
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+
+  // read with the library backend
+  File file;
+  file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  auto half = file.frame_number() / 2;
+  auto first_half = file.ReadAsync(half);
+  auto second_half = file.ReadAsync(file.frame_number() - half);
+  auto error = file.ReadAsync(1);
+  auto blocks = first_half.get();
+  auto second_block = second_half.get();
+  blocks.insert(blocks.end(), second_block.begin(), second_block.end());
+  ASSERT_EQ(blocks, content);
+  try {
+    error.get();
+    FAIL();
+  } catch (const std::system_error& e) {
+    ASSERT_EQ(e.code(), make_error_code(kInvalidFormat));
+  }
+
+  // write the blocks back, in order
+  {
+    File write_file;
+    ASSERT_THROW(write_file.WriteAsync(blocks).get(), std::system_error);
+    write_file.Open(gResourcePath + "/output.wav", OpenMode::kOut);
+    write_file.set_sample_rate(read_file.sample_rate());
+    write_file.set_bits_per_sample(read_file.bits_per_sample());
+    write_file.set_channel_number(read_file.channel_number());
+    auto block_samples = content.size() / 4;
+    std::vector<std::future<void>> writes;
+    for (size_t idx = 0; idx < content.size(); idx += block_samples) {
+      auto end = std::min(content.size(), idx + block_samples);
+      std::vector<float> block(content.begin() + idx, content.begin() + end);
+      writes.push_back(write_file.WriteAsync(std::move(block)));
+    }
+    // the last write is done once the File is closed
+    writes.front().get();
+  }
+  File re_read_file;
+  re_read_file.Open(gResourcePath + "/output.wav", OpenMode::kIn);
+  std::vector<float> re_read_content;
+  ASSERT_EQ(re_read_file.Read(&re_read_content), kNoError);
+  ASSERT_EQ(content, re_read_content);
+}
+
 #endif  // __cplusplus > 199711L
 
+#ifdef __cpp_impl_coroutine
+namespace {
+// fire and forget coroutine, enough to test the awaitables
+struct Task {
+  struct promise_type {
+    Task get_return_object() { return Task(); }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+Task CopyCoroutine(wave::File* input, wave::File* output,
+                   std::promise<wave::Error>* done) {
+  try {
+    auto content = co_await wave::ReadAwaitable(input, input->frame_number());
+    co_await wave::WriteAwaitable(output, std::move(content));
+    co_await wave::ReadAwaitable(input, 1);
+    done->set_value(wave::kNoError);
+  } catch (const std::system_error& e) {
+    done->set_value(e.code() == wave::make_error_code(wave::kInvalidFormat)
+                        ? wave::kInvalidFormat
+                        : wave::kNoError);
+  }
+}
+}  // namespace
+
+TEST(Wave, Coroutines) {
+  using namespace wave;
+  File input;
+  input.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::promise<Error> done;
+  {
+    File output;
+    output.Open(gResourcePath + "/output.wav", OpenMode::kOut);
+    output.set_sample_rate(input.sample_rate());
+    output.set_channel_number(input.channel_number());
+    CopyCoroutine(&input, &output, &done);
+    // reading past the end fails
+    ASSERT_EQ(done.get_future().get(), kInvalidFormat);
+  }
+  File re_read_file;
+  re_read_file.Open(gResourcePath + "/output.wav", OpenMode::kIn);
+  ASSERT_EQ(re_read_file.frame_number(), input.frame_number());
+}
+#endif  // __cpp_impl_coroutine
+
+TEST(Wave, Reopen) {
+  using namespace wave;
+
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+
+  // reuse the same object to write, then read back the written file
+  File file;
+  ASSERT_EQ(file.Open(gResourcePath + "/extra-header.wav", OpenMode::kIn),
+            kNoError);
+  std::vector<float> p1;
+  ASSERT_EQ(file.Read(20, &p1), kNoError);
+
+  ASSERT_EQ(file.Reopen(gResourcePath + "/output.wav", OpenMode::kOut),
+            kNoError);
+  file.set_sample_rate(read_file.sample_rate());
+  file.set_bits_per_sample(read_file.bits_per_sample());
+  file.set_channel_number(read_file.channel_number());
+  ASSERT_EQ(file.Write(content), kNoError);
+
+  ASSERT_EQ(file.Reopen(gResourcePath + "/output.wav", OpenMode::kIn),
+            kNoError);
+  ASSERT_EQ(file.Tell(), 0);
+  std::vector<float> re_read_content;
+  ASSERT_EQ(file.Read(&re_read_content), kNoError);
+  ASSERT_EQ(content, re_read_content);
+
+  // reset restores the default format and closes the file
+  file.Reset();
+  ASSERT_EQ(file.sample_rate(), 44100);
+  ASSERT_EQ(file.channel_number(), 1);
+  ASSERT_EQ(file.Read(&re_read_content), kNotOpen);
+}
+
+TEST(Wave, Buffer) {
+  using namespace wave;
+
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+
+  // load the whole file in memory and decode from there
+  std::ifstream stream(gResourcePath + "/Untitled3.wav", std::ios::binary);
+  std::vector<char> file_content((std::istreambuf_iterator<char>(stream)),
+                                 std::istreambuf_iterator<char>());
+  File memory_file;
+  ASSERT_EQ(memory_file.OpenBuffer(file_content.data(), file_content.size()),
+            kNoError);
+  ASSERT_EQ(memory_file.sample_rate(), read_file.sample_rate());
+  ASSERT_EQ(memory_file.frame_number(), read_file.frame_number());
+  std::vector<float> memory_content;
+  ASSERT_EQ(memory_file.Read(&memory_content), kNoError);
+  ASSERT_EQ(content, memory_content);
+  ASSERT_EQ(memory_file.Write(content), kNotOpen);
+
+  // write to a growable buffer, it should hold the same bytes as a file
+  std::vector<char> sink;
+  {
+    File write_file;
+    ASSERT_EQ(write_file.OpenBuffer(&sink, OpenMode::kOut), kNoError);
+    write_file.set_sample_rate(read_file.sample_rate());
+    write_file.set_bits_per_sample(read_file.bits_per_sample());
+    write_file.set_channel_number(read_file.channel_number());
+    ASSERT_EQ(write_file.Write(content), kNoError);
+
+    ASSERT_EQ(write_file.Reopen(gResourcePath + "/output.wav", OpenMode::kOut),
+              kNoError);
+    write_file.set_sample_rate(read_file.sample_rate());
+    write_file.set_bits_per_sample(read_file.bits_per_sample());
+    write_file.set_channel_number(read_file.channel_number());
+    ASSERT_EQ(write_file.Write(content), kNoError);
+  }
+  std::ifstream output_stream(gResourcePath + "/output.wav", std::ios::binary);
+  std::vector<char> output_content(
+      (std::istreambuf_iterator<char>(output_stream)),
+      std::istreambuf_iterator<char>());
+  ASSERT_EQ(sink, output_content);
+
+  File sink_file;
+  ASSERT_EQ(sink_file.OpenBuffer(&sink, OpenMode::kIn), kNoError);
+  std::vector<float> sink_content;
+  ASSERT_EQ(sink_file.Read(&sink_content), kNoError);
+  ASSERT_EQ(content, sink_content);
+}
+
+TEST(Wave, WriteDirect) {
+  using namespace wave;
+
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+
+  // write the content twice, with the regular and the direct writer
+  std::vector<std::vector<char>> outputs;
+  for (auto direct : {false, true}) {
+    auto path = gResourcePath + (direct ? "/output-direct.wav" : "/output.wav");
+    {
+      File write_file;
+      auto error = direct ? write_file.OpenDirect(path)
+                          : write_file.Open(path, OpenMode::kOut);
+      ASSERT_EQ(error, kNoError);
+      write_file.set_sample_rate(read_file.sample_rate());
+      write_file.set_bits_per_sample(read_file.bits_per_sample());
+      write_file.set_channel_number(read_file.channel_number());
+      write_file.set_expected_frame_number(2 * read_file.frame_number());
+      ASSERT_EQ(write_file.Write(content), kNoError);
+      ASSERT_EQ(write_file.Write(content), kNoError);
+      ASSERT_EQ(write_file.Tell(), 2 * read_file.frame_number());
+    }
+    std::ifstream stream(path, std::ios::binary);
+    outputs.emplace_back((std::istreambuf_iterator<char>(stream)),
+                         std::istreambuf_iterator<char>());
+  }
+  ASSERT_EQ(outputs[0], outputs[1]);
+
+  File re_read_file;
+  re_read_file.Open(gResourcePath + "/output-direct.wav", OpenMode::kIn);
+  ASSERT_EQ(re_read_file.frame_number(), 2 * read_file.frame_number());
+}
+
+void CopyFile(const std::string& source, const std::string& destination) {
+  std::ifstream input(source, std::ios::binary);
+  std::ofstream output(destination, std::ios::binary | std::ios::trunc);
+  output << input.rdbuf();
+}
+
+uint64_t FileSize(const std::string& path) {
+  std::ifstream stream(path, std::ios::binary | std::ios::ate);
+  return stream.tellg();
+}
+
+TEST(Wave, ReadChunks) {
+  using namespace wave;
+  File file;
+  ASSERT_EQ(file.Open(gResourcePath + "/extra-header.wav", OpenMode::kIn),
+            kNoError);
+  ASSERT_EQ(file.chunk_ids(), std::vector<std::string>({"cue ", "bext"}));
+
+  std::vector<char> content;
+  ASSERT_EQ(file.ReadChunk("cue ", &content), kNoError);
+  ASSERT_EQ(content.size(), 52);
+  ASSERT_EQ(file.ReadChunk("LIST", &content), kChunkNotFound);
+  BroadcastExtension extension;
+  ASSERT_EQ(file.ReadChunk(&extension), kNoError);
+
+  // reading chunks doesn't move the position in samples
+  std::vector<float> first_frames, frames;
+  ASSERT_EQ(file.Read(10, &first_frames), kNoError);
+  file.Seek(0);
+  file.ReadChunk("bext", &content);
+  ASSERT_EQ(file.Read(10, &frames), kNoError);
+  ASSERT_EQ(first_frames, frames);
+  // chunks can't be written in kIn mode
+  ASSERT_EQ(file.WriteChunk("LIST", content), kNotOpen);
+}
+
+TEST(Wave, UpdateChunks) {
+  using namespace wave;
+  auto path = gResourcePath + "/output-chunks.wav";
+  CopyFile(gResourcePath + "/extra-header.wav", path);
+  auto original_size = FileSize(path);
+
+  std::vector<float> samples;
+  {
+    File file;
+    ASSERT_EQ(file.Open(path, OpenMode::kUpdate), kNoError);
+    ASSERT_EQ(file.Read(&samples), kNoError);
+    ASSERT_EQ(file.Write(samples), kNotOpen);
+
+    std::vector<char> content;
+    file.ReadChunk("bext", &content);
+    auto original_bext_size = content.size() + (content.size() & 1);
+
+    // same size: updated in place
+    BroadcastExtension extension;
+    ASSERT_EQ(file.ReadChunk(&extension), kNoError);
+    extension.description = "updated description";
+    ASSERT_EQ(file.WriteChunk(extension), kNoError);
+    ASSERT_EQ(FileSize(path), original_size);
+
+    // bext is the last chunk, it grows in place
+    extension.coding_history = std::string(2000, 'h');
+    auto bext_size = SerializeBroadcastExtension(extension).size();
+    ASSERT_EQ(file.WriteChunk(extension), kNoError);
+    auto grown_size = FileSize(path);
+    ASSERT_EQ(grown_size, original_size - original_bext_size + bext_size);
+
+    // cue doesn't fit anymore: it moves to the end, leaving padding
+    std::vector<char> cue(100, 'c');
+    ASSERT_EQ(file.WriteChunk("cue ", cue), kNoError);
+    ASSERT_EQ(FileSize(path), grown_size + 8 + cue.size());
+    ASSERT_EQ(file.chunk_ids(), std::vector<std::string>({"bext", "cue "}));
+
+    // a new chunk takes the padding left by cue
+    std::vector<char> list(21, 'l');
+    ASSERT_EQ(file.WriteChunk("LIST", list), kNoError);
+    ASSERT_EQ(FileSize(path), grown_size + 8 + cue.size());
+    ASSERT_EQ(file.chunk_ids(),
+              std::vector<std::string>({"LIST", "bext", "cue "}));
+
+    // cue is last, it shrinks in place by less than a padding chunk and the
+    // next chunk follows it
+    cue.resize(96);
+    ASSERT_EQ(file.WriteChunk("cue ", cue), kNoError);
+    ASSERT_EQ(FileSize(path), grown_size + 8 + 100);
+    std::vector<char> id3(100, 'i');
+    ASSERT_EQ(file.WriteChunk("id3 ", id3), kNoError);
+    ASSERT_EQ(FileSize(path), grown_size + 8 + 96 + 8 + id3.size());
+    ASSERT_EQ(file.chunk_ids(),
+              std::vector<std::string>({"LIST", "bext", "cue ", "id3 "}));
+
+    ASSERT_EQ(file.WriteChunk("data", list), kInvalidFormat);
+  }
+
+  File file;
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_EQ(file.chunk_ids(),
+            std::vector<std::string>({"LIST", "bext", "cue ", "id3 "}));
+  BroadcastExtension extension;
+  ASSERT_EQ(file.ReadChunk(&extension), kNoError);
+  ASSERT_EQ(extension.description, "updated description");
+  ASSERT_EQ(extension.coding_history, std::string(2000, 'h'));
+  std::vector<char> content;
+  ASSERT_EQ(file.ReadChunk("cue ", &content), kNoError);
+  ASSERT_EQ(content, std::vector<char>(96, 'c'));
+  ASSERT_EQ(file.ReadChunk("LIST", &content), kNoError);
+  ASSERT_EQ(content, std::vector<char>(21, 'l'));
+  ASSERT_EQ(file.ReadChunk("id3 ", &content), kNoError);
+  ASSERT_EQ(content, std::vector<char>(100, 'i'));
+
+  std::vector<float> re_read_samples;
+  ASSERT_EQ(file.Read(&re_read_samples), kNoError);
+  ASSERT_EQ(samples, re_read_samples);
+}
+
+TEST(Wave, WriteChunks) {
+  using namespace wave;
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+
+  auto extension = MakeBroadcastExtension();
+  extension.description = "written";
+  extension.time_reference = 1ull << 40;
+  std::vector<char> odd_chunk(11, 'o');
+  {
+    File write_file;
+    write_file.Open(gResourcePath + "/output.wav", OpenMode::kOut);
+    write_file.set_sample_rate(read_file.sample_rate());
+    write_file.set_bits_per_sample(read_file.bits_per_sample());
+    write_file.set_channel_number(read_file.channel_number());
+    ASSERT_EQ(write_file.WriteChunk("odd ", odd_chunk), kNoError);
+    ASSERT_EQ(write_file.WriteChunk(extension), kNoError);
+    write_file.Write(content);
+  }
+
+  File re_read_file;
+  ASSERT_EQ(re_read_file.Open(gResourcePath + "/output.wav", OpenMode::kIn),
+            kNoError);
+  ASSERT_EQ(re_read_file.chunk_ids(),
+            std::vector<std::string>({"odd ", "bext"}));
+  BroadcastExtension re_read_extension;
+  ASSERT_EQ(re_read_file.ReadChunk(&re_read_extension), kNoError);
+  ASSERT_EQ(re_read_extension.description, "written");
+  ASSERT_EQ(re_read_extension.time_reference, 1ull << 40);
+  std::vector<char> chunk;
+  ASSERT_EQ(re_read_file.ReadChunk("odd ", &chunk), kNoError);
+  ASSERT_EQ(chunk, odd_chunk);
+  std::vector<float> re_read_content;
+  ASSERT_EQ(re_read_file.Read(&re_read_content), kNoError);
+  ASSERT_EQ(content, re_read_content);
+}
+
+TEST(Wave, Append) {
+  using namespace wave;
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+  auto half = content.size() / 2;
+
+  auto path = gResourcePath + "/output-append.wav";
+  {
+    File write_file;
+    write_file.Open(path, OpenMode::kOut);
+    write_file.set_sample_rate(read_file.sample_rate());
+    write_file.set_bits_per_sample(read_file.bits_per_sample());
+    write_file.set_channel_number(read_file.channel_number());
+    write_file.Write(std::vector<float>(content.begin(), content.begin() + half));
+  }
+  {
+    File append_file;
+    ASSERT_EQ(append_file.Open(path, OpenMode::kAppend), kNoError);
+    ASSERT_EQ(append_file.Tell(), half / read_file.channel_number());
+    ASSERT_EQ(append_file.Write(
+                  std::vector<float>(content.begin() + half, content.end())),
+              kNoError);
+    ASSERT_EQ(append_file.frame_number(), read_file.frame_number());
+  }
+
+  File re_read_file;
+  ASSERT_EQ(re_read_file.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_EQ(re_read_file.frame_number(), read_file.frame_number());
+  std::vector<float> re_read_content;
+  ASSERT_EQ(re_read_file.Read(&re_read_content), kNoError);
+  ASSERT_EQ(content, re_read_content);
+}
+
+TEST(Wave, AppendTrailingChunks) {
+  using namespace wave;
+  auto path = gResourcePath + "/output-append-chunks.wav";
+  CopyFile(gResourcePath + "/extra-header.wav", path);
+
+  std::vector<float> samples;
+  std::vector<char> bext;
+  uint64_t frame_number = 0;
+  {
+    File file;
+    ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+    ASSERT_EQ(file.Read(&samples), kNoError);
+    ASSERT_EQ(file.ReadChunk("bext", &bext), kNoError);
+    frame_number = file.frame_number();
+  }
+
+  std::vector<float> appended(1000 * 2, 0.5f);
+  {
+    File file;
+    ASSERT_EQ(file.Open(path, OpenMode::kAppend), kNoError);
+    // trailing chunks are still visible
+    ASSERT_EQ(file.chunk_ids(), std::vector<std::string>({"cue ", "bext"}));
+
+    // the format can't change
+    file.set_sample_rate(file.sample_rate() * 2);
+    ASSERT_EQ(file.Write(appended), kInvalidFormat);
+    file.set_sample_rate(file.sample_rate() / 2);
+    ASSERT_EQ(file.Write(appended), kNoError);
+  }
+
+  File file;
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_EQ(file.frame_number(), frame_number + 1000);
+  ASSERT_EQ(file.chunk_ids(), std::vector<std::string>({"cue ", "bext"}));
+  std::vector<char> content;
+  ASSERT_EQ(file.ReadChunk("bext", &content), kNoError);
+  ASSERT_EQ(content, bext);
+
+  std::vector<float> re_read_samples;
+  ASSERT_EQ(file.Read(frame_number, &re_read_samples), kNoError);
+  ASSERT_EQ(samples, re_read_samples);
+  ASSERT_EQ(file.Read(1000, &re_read_samples), kNoError);
+  for (auto sample : re_read_samples) {
+    ASSERT_NEAR(sample, 0.5f, 1e-4);
+  }
+}
+
+TEST(Wave, RawCopy) {
+  using namespace wave;
+  File read_file;
+  ASSERT_EQ(read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn),
+            kNoError);
+  std::vector<char> first_half, second_half;
+  auto half = read_file.frame_number() / 2;
+  ASSERT_EQ(read_file.ReadRaw(half, &first_half), kNoError);
+  ASSERT_EQ(first_half.size(),
+            half * read_file.channel_number() * read_file.bits_per_sample() / 8);
+  ASSERT_EQ(read_file.ReadRaw(read_file.frame_number() - half, XOR,
+                              &second_half),
+            kNoError);
+  ASSERT_EQ(read_file.ReadRaw(1, &second_half), kInvalidFormat);
+
+  {
+    File write_file;
+    write_file.Open(gResourcePath + "/output.wav", OpenMode::kOut);
+    write_file.set_sample_rate(read_file.sample_rate());
+    write_file.set_bits_per_sample(read_file.bits_per_sample());
+    write_file.set_channel_number(read_file.channel_number());
+    // only whole frames can be written
+    ASSERT_EQ(write_file.WriteRaw(std::vector<char>(3)), kInvalidFormat);
+    ASSERT_EQ(write_file.WriteRaw(first_half), kNoError);
+    ASSERT_EQ(write_file.WriteRaw(second_half, XOR), kNoError);
+  }
+
+  File re_read_file;
+  ASSERT_EQ(re_read_file.Open(gResourcePath + "/output.wav", OpenMode::kIn),
+            kNoError);
+  ASSERT_EQ(re_read_file.frame_number(), read_file.frame_number());
+  std::vector<float> content, re_read_content;
+  read_file.Seek(0);
+  read_file.Read(&content);
+  ASSERT_EQ(re_read_file.Read(&re_read_content), kNoError);
+  ASSERT_EQ(content, re_read_content);
+}
+
+TEST(Wave, RawCopy32bits) {
+  using namespace wave;
+  // 32 bits samples don't survive a float round trip, raw copies are exact
+  std::vector<int32_t> samples = {std::numeric_limits<int32_t>::max(), -1, 1,
+                                  123456789};
+  std::vector<char> data(samples.size() * sizeof(int32_t));
+  memcpy(data.data(), samples.data(), data.size());
+  std::vector<char> buffer;
+  {
+    File file;
+    ASSERT_EQ(file.OpenBuffer(&buffer, OpenMode::kOut), kNoError);
+    file.set_bits_per_sample(32);
+    file.set_channel_number(2);
+    ASSERT_EQ(file.WriteRaw(data), kNoError);
+  }
+
+  File file;
+  ASSERT_EQ(file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  std::vector<char> re_read_data;
+  ASSERT_EQ(file.ReadRaw(2, &re_read_data), kNoError);
+  ASSERT_EQ(data, re_read_data);
+}
+
+TEST(Wave, ReadTyped) {
+  using namespace wave;
+  File file;
+  ASSERT_EQ(file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn),
+            kNoError);
+  std::vector<char> raw;
+  ASSERT_EQ(file.ReadRaw(file.frame_number(), &raw), kNoError);
+  std::vector<float> floats;
+  file.Seek(0);
+  ASSERT_EQ(file.Read(&floats), kNoError);
+
+  // 16 bits samples are copied as they are
+  std::vector<int16_t> shorts;
+  file.Seek(0);
+  ASSERT_EQ(file.Read(&shorts), kNoError);
+  ASSERT_EQ(shorts.size() * sizeof(int16_t), raw.size());
+  ASSERT_EQ(memcmp(shorts.data(), raw.data(), raw.size()), 0);
+
+  std::vector<int32_t> ints;
+  file.Seek(0);
+  ASSERT_EQ(file.Read(file.frame_number(), &ints), kNoError);
+  std::vector<double> doubles;
+  file.Seek(0);
+  ASSERT_EQ(file.Read<double>(&doubles), kNoError);
+  ASSERT_EQ(doubles.size(), shorts.size());
+  for (size_t idx = 0; idx < shorts.size(); idx++) {
+    ASSERT_EQ(ints[idx], shorts[idx] * 65536);
+    ASSERT_EQ(doubles[idx], shorts[idx] / 32767.);
+    ASSERT_FLOAT_EQ(doubles[idx], floats[idx]);
+  }
+}
+
+TEST(Wave, WriteTyped) {
+  using namespace wave;
+  // 32 bits samples survive a round trip through int32_t and double
+  std::vector<int32_t> samples = {std::numeric_limits<int32_t>::max(), -1, 1,
+                                  123456789, -123456789, 0};
+  std::vector<char> buffer;
+  {
+    File file;
+    ASSERT_EQ(file.OpenBuffer(&buffer, OpenMode::kOut), kNoError);
+    file.set_bits_per_sample(32);
+    file.set_channel_number(2);
+    ASSERT_EQ(file.Write(samples), kNoError);
+  }
+  {
+    File file;
+    ASSERT_EQ(file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+    std::vector<int32_t> re_read_samples;
+    ASSERT_EQ(file.Read(&re_read_samples), kNoError);
+    ASSERT_EQ(samples, re_read_samples);
+
+    std::vector<double> doubles;
+    file.Seek(0);
+    ASSERT_EQ(file.Read(&doubles), kNoError);
+    {
+      File double_file;
+      ASSERT_EQ(double_file.OpenBuffer(&buffer, OpenMode::kOut), kNoError);
+      double_file.set_bits_per_sample(32);
+      double_file.set_channel_number(2);
+      ASSERT_EQ(double_file.Write(doubles), kNoError);
+    }
+  }
+  File file;
+  ASSERT_EQ(file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  std::vector<int32_t> re_read_samples;
+  ASSERT_EQ(file.Read(&re_read_samples), kNoError);
+  ASSERT_EQ(samples, re_read_samples);
+
+  // 24 bits files keep the 16 bits samples
+  std::vector<int16_t> shorts = {32767, -32768, 1, -1, 1234, 0};
+  {
+    File short_file;
+    ASSERT_EQ(short_file.OpenBuffer(&buffer, OpenMode::kOut), kNoError);
+    short_file.set_bits_per_sample(24);
+    ASSERT_EQ(short_file.Write(shorts), kNoError);
+  }
+  ASSERT_EQ(file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  std::vector<int16_t> re_read_shorts;
+  ASSERT_EQ(file.Read(&re_read_shorts), kNoError);
+  ASSERT_EQ(shorts, re_read_shorts);
+}
+
+TEST(Wave, Checksum) {
+  using namespace wave;
+  File read_file;
+  read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn);
+  std::vector<float> content;
+  read_file.Read(&content);
+
+  auto path = gResourcePath + "/output-checksum.wav";
+  uint32_t checksum = 0;
+  {
+    File write_file;
+    write_file.Open(path, OpenMode::kOut);
+    write_file.set_sample_rate(read_file.sample_rate());
+    write_file.set_bits_per_sample(read_file.bits_per_sample());
+    write_file.set_channel_number(read_file.channel_number());
+    write_file.set_checksum_enabled(true);
+    auto half = content.size() / 2;
+    write_file.Write(std::vector<float>(content.begin(), content.begin() + half),
+                     XOR);
+    write_file.Write(std::vector<float>(content.begin() + half, content.end()),
+                     XOR);
+    checksum = write_file.checksum();
+    ASSERT_NE(checksum, 0);
+    ASSERT_EQ(write_file.WriteChecksum(), kNoError);
+  }
+
+  // samples are checksummed as stored, before decryption
+  File file;
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_EQ(file.chunk_ids(), std::vector<std::string>({"crc "}));
+  file.set_checksum_enabled(true);
+  std::vector<float> re_read_content;
+  ASSERT_EQ(file.Read(XOR, &re_read_content), kNoError);
+  ASSERT_EQ(content, re_read_content);
+  ASSERT_EQ(file.checksum(), checksum);
+  ASSERT_EQ(file.VerifyChecksum(), kNoError);
+
+  std::vector<char> raw;
+  file.Seek(0);
+  file.set_checksum_enabled(true);
+  ASSERT_EQ(file.ReadRaw(file.frame_number(), &raw), kNoError);
+  ASSERT_EQ(file.checksum(), checksum);
+
+  // a changed sample is detected
+  raw[1000] ^= 1;
+  std::vector<char> buffer;
+  {
+    File corrupted_file;
+    corrupted_file.OpenBuffer(&buffer, OpenMode::kOut);
+    corrupted_file.set_sample_rate(file.sample_rate());
+    corrupted_file.set_channel_number(file.channel_number());
+    corrupted_file.WriteRaw(raw);
+    std::vector<char> stored_checksum;
+    file.ReadChunk("crc ", &stored_checksum);
+    corrupted_file.WriteChunk("crc ", stored_checksum);
+  }
+  File corrupted_file;
+  ASSERT_EQ(corrupted_file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  corrupted_file.set_checksum_enabled(true);
+  ASSERT_EQ(corrupted_file.Read(&re_read_content), kNoError);
+  ASSERT_EQ(corrupted_file.VerifyChecksum(), kInvalidChecksum);
+
+  ASSERT_EQ(read_file.VerifyChecksum(), kChunkNotFound);
+}
+
+TEST(Wave, ReadRawAt) {
+  using namespace wave;
+  auto path = gResourcePath + "/Untitled3.wav";
+  File read_file;
+  read_file.Open(path, OpenMode::kIn);
+  std::vector<char> raw;
+  read_file.ReadRaw(read_file.frame_number(), &raw);
+  std::ifstream stream(path, std::ios::binary);
+  std::vector<char> buffer((std::istreambuf_iterator<char>(stream)),
+                           std::istreambuf_iterator<char>());
+
+  // positional reads on disk and in memory, seek and read in vectors
+  File file, memory_file, vector_file;
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_EQ(memory_file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  ASSERT_EQ(vector_file.OpenBuffer(&buffer, OpenMode::kIn), kNoError);
+  auto frame_size = raw.size() / file.frame_number();
+  for (auto opened : {&file, &memory_file, &vector_file}) {
+    ASSERT_EQ(opened->Seek(10), kNoError);
+    std::vector<char> bytes;
+    ASSERT_EQ(opened->ReadRawAt(1000, 500, &bytes), kNoError);
+    ASSERT_EQ(bytes, std::vector<char>(raw.begin() + 1000 * frame_size,
+                                       raw.begin() + 1500 * frame_size));
+    // the position of Read doesn't move
+    ASSERT_EQ(opened->Tell(), 10);
+    auto frame_number = opened->frame_number();
+    ASSERT_EQ(opened->ReadRawAt(frame_number - 1, 2, &bytes),
+              kInvalidFormat);
+    ASSERT_EQ(opened->ReadRawAt(frame_number + 1, 0, &bytes), kInvalidSeek);
+  }
+  File closed_file;
+  std::vector<char> bytes;
+  ASSERT_EQ(closed_file.ReadRawAt(0, 1, &bytes), kNotOpen);
+}
+
+TEST(Wave, Crc32c) {
+  using namespace wave;
+  std::string check = "123456789";
+  ASSERT_EQ(internal::Crc32c(0, check.data(), check.size()), 0xe3069283);
+
+  // long sizes are folded in wide blocks, small pieces byte by byte, both
+  // from unaligned addresses
+  std::vector<char> data(20000);
+  for (size_t idx = 0; idx < data.size(); idx++) {
+    data[idx] = static_cast<char>(idx * 31 + idx / 251);
+  }
+  for (size_t size : {0, 1, 127, 128, 200, 511, 512, 777, 4096, 19997}) {
+    auto bytes = data.data() + 3;
+    uint32_t piecewise = 0;
+    for (size_t offset = 0; offset < size; offset += 7) {
+      piecewise = internal::Crc32c(piecewise, bytes + offset,
+                                   std::min<size_t>(7, size - offset));
+    }
+    ASSERT_EQ(internal::Crc32c(0, bytes, size), piecewise) << size;
+  }
+}
+
+TEST(Wave, GainAndLevels) {
+  using namespace wave;
+  File file;
+  ASSERT_EQ(file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn),
+            kNoError);
+  std::vector<float> content;
+  ASSERT_EQ(file.Read(&content), kNoError);
+  ASSERT_TRUE(file.levels().empty());
+
+  // first pass: measure
+  file.Seek(0);
+  file.set_levels_enabled(true);
+  std::vector<float> measured;
+  ASSERT_EQ(file.Read(&measured), kNoError);
+  ASSERT_EQ(content, measured);
+  auto levels = file.levels();
+  ASSERT_EQ(levels.size(), 2);
+  for (size_t channel = 0; channel < 2; channel++) {
+    float peak = 0.f;
+    double sum_of_squares = 0.;
+    for (size_t idx = channel; idx < content.size(); idx += 2) {
+      peak = std::max(peak, std::fabs(content[idx]));
+      sum_of_squares += static_cast<double>(content[idx]) * content[idx];
+    }
+    ASSERT_GT(peak, 0.f);
+    ASSERT_EQ(levels[channel].peak, peak);
+    ASSERT_NEAR(levels[channel].sum_of_squares, sum_of_squares,
+                sum_of_squares * 1e-9);
+  }
+
+  // second pass: normalize each channel, in blocks that don't start on the
+  // first channel of a read block
+  file.Seek(0);
+  file.set_gain({1.f / levels[0].peak, 1.f / levels[1].peak});
+  file.set_levels_enabled(true);
+  std::vector<float> normalized, block;
+  while (normalized.size() < content.size()) {
+    auto frame_number = std::min<uint64_t>(
+        12345, file.frame_number() - file.Tell());
+    ASSERT_EQ(file.Read(frame_number, &block), kNoError);
+    normalized.insert(normalized.end(), block.begin(), block.end());
+  }
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    ASSERT_EQ(normalized[idx], content[idx] * (1.f / levels[idx % 2].peak));
+  }
+  ASSERT_FLOAT_EQ(file.levels()[0].peak, 1.f);
+  ASSERT_FLOAT_EQ(file.levels()[1].peak, 1.f);
+
+  // integer samples are left untouched
+  file.Seek(0);
+  std::vector<int16_t> shorts;
+  ASSERT_EQ(file.Read(10, &shorts), kNoError);
+  ASSERT_EQ(shorts[0], static_cast<int16_t>(content[0] * 32767));
+
+  file.set_gain({1.f, 1.f, 1.f});
+  ASSERT_EQ(file.Read(10, &block), kInvalidFormat);
+
+  // gain on write leaves the given samples untouched
+  std::vector<char> buffer;
+  {
+    File write_file;
+    write_file.OpenBuffer(&buffer, OpenMode::kOut);
+    write_file.set_channel_number(2);
+    write_file.set_bits_per_sample(32);
+    write_file.set_gain(0.5f);
+    write_file.set_levels_enabled(true);
+    auto copy = content;
+    ASSERT_EQ(write_file.Write(copy), kNoError);
+    ASSERT_EQ(copy, content);
+    ASSERT_FLOAT_EQ(write_file.levels()[0].peak, levels[0].peak * 0.5f);
+  }
+  File re_read_file;
+  re_read_file.OpenBuffer(buffer.data(), buffer.size());
+  std::vector<double> re_read_content;
+  ASSERT_EQ(re_read_file.Read(&re_read_content), kNoError);
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    ASSERT_NEAR(re_read_content[idx], content[idx] * 0.5, 1e-7);
+  }
+}
+
+TEST(Wave, Mix) {
+  using namespace wave;
+  // 5.1
+  const size_t kChannelNumber = 6;
+  std::vector<float> content(100000 * kChannelNumber);
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    content[idx] = static_cast<float>((idx * 37) % 1000) / 4000.f - 0.125f;
+  }
+  std::vector<char> buffer;
+  {
+    File write_file;
+    write_file.OpenBuffer(&buffer, OpenMode::kOut);
+    write_file.set_channel_number(kChannelNumber);
+    write_file.set_bits_per_sample(32);
+    ASSERT_EQ(write_file.Write(content), kNoError);
+  }
+  File file;
+  ASSERT_EQ(file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  ASSERT_EQ(file.Read(&content), kNoError);
+
+  auto check = [&](const std::vector<std::vector<float>>& matrix) {
+    file.Seek(0);
+    file.set_mix_matrix(matrix);
+    // in reads that are not a multiple of the mixed frames
+    std::vector<float> mixed, block;
+    while (file.Tell() < file.frame_number()) {
+      auto frame_number =
+          std::min<uint64_t>(7777, file.frame_number() - file.Tell());
+      ASSERT_EQ(file.Read(frame_number, &block), kNoError);
+      ASSERT_EQ(block.size(), frame_number * matrix.size());
+      mixed.insert(mixed.end(), block.begin(), block.end());
+    }
+    ASSERT_EQ(mixed.size(), file.frame_number() * matrix.size());
+    for (size_t frame = 0; frame < file.frame_number(); frame++) {
+      for (size_t output = 0; output < matrix.size(); output++) {
+        float expected = 0.f;
+        for (size_t channel = 0; channel < kChannelNumber; channel++) {
+          expected += matrix[output][channel] *
+                      content[frame * kChannelNumber + channel];
+        }
+        ASSERT_NEAR(mixed[frame * matrix.size() + output], expected, 1e-6);
+      }
+    }
+  };
+  auto stereo = DownmixMatrix(kChannelNumber, 2);
+  ASSERT_EQ(stereo.size(), 2);
+  ASSERT_EQ(stereo[0][3], 0.f);
+  check(stereo);
+  check(DownmixMatrix(kChannelNumber, 1));
+  check({{0.f, 0.f, 0.f, 1.f, 0.f, 0.f},
+         {1.f, -1.f, 0.f, 0.f, 0.f, 0.f},
+         {0.f, 0.f, 0.f, 0.f, 0.5f, 0.5f}});
+
+  // gain applies before mixing
+  file.Seek(0);
+  file.set_mix_matrix(DownmixMatrix(kChannelNumber, 1));
+  file.set_gain(2.f);
+  std::vector<double> doubled;
+  ASSERT_EQ(file.Read(10, &doubled), kNoError);
+  ASSERT_EQ(doubled.size(), 10);
+  ASSERT_NEAR(doubled[0],
+              content[0] + content[1] + 0.70710678 * 2 * content[2] +
+                  0.70710678 * (content[4] + content[5]),
+              1e-6);
+  file.set_gain(1.f);
+
+  // errors
+  std::vector<int16_t> shorts;
+  ASSERT_EQ(file.Read(10, &shorts), kInvalidFormat);
+  file.set_mix_matrix({{1.f, 1.f}});
+  std::vector<float> block;
+  ASSERT_EQ(file.Read(10, &block), kInvalidFormat);
+  file.set_mix_matrix({});
+  ASSERT_EQ(file.Read(10, &block), kNoError);
+  ASSERT_EQ(block.size(), 10 * kChannelNumber);
+  ASSERT_TRUE(DownmixMatrix(5, 2).empty());
+  ASSERT_TRUE(DownmixMatrix(8, 3).empty());
+  ASSERT_EQ(DownmixMatrix(2, 1), std::vector<std::vector<float>>({{.5f, .5f}}));
+}
+
+TEST(Wave, BigEndian) {
+  using namespace wave;
+  // RIFX file of 2 mono 16 bits samples, built by hand
+  std::vector<char> rifx = {
+      'R', 'I', 'F', 'X', 0, 0, 0, 40, 'W', 'A', 'V', 'E',
+      'f', 'm', 't', ' ', 0, 0, 0, 16, 0, 1, 0, 1,
+      0, 0, 0x1f, 0x40, 0, 0, 0x3e, (char)0x80, 0, 2, 0, 16,
+      'd', 'a', 't', 'a', 0, 0, 0, 4, 0x7f, (char)0xff, (char)0x80, 0x01};
+  File file;
+  ASSERT_EQ(file.OpenBuffer(rifx.data(), rifx.size()), kNoError);
+  ASSERT_TRUE(file.big_endian());
+  ASSERT_EQ(file.sample_rate(), 8000);
+  ASSERT_EQ(file.channel_number(), 1);
+  ASSERT_EQ(file.frame_number(), 2);
+  std::vector<int16_t> shorts;
+  ASSERT_EQ(file.Read(&shorts), kNoError);
+  ASSERT_EQ(shorts, std::vector<int16_t>({32767, -32767}));
+  file.Seek(0);
+  std::vector<float> floats;
+  ASSERT_EQ(file.Read(&floats), kNoError);
+  ASSERT_EQ(floats, std::vector<float>({1.f, -1.f}));
+
+  // written RIFX files read like RIFF ones, at every bit depth
+  File read_file;
+  ASSERT_EQ(read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn),
+            kNoError);
+  std::vector<float> content;
+  ASSERT_EQ(read_file.Read(&content), kNoError);
+  for (uint16_t bits_per_sample : {16, 24, 32}) {
+    std::vector<char> little, big;
+    for (auto big_endian : {false, true}) {
+      File write_file;
+      write_file.OpenBuffer(big_endian ? &big : &little, OpenMode::kOut);
+      write_file.set_big_endian(big_endian);
+      write_file.set_channel_number(2);
+      write_file.set_bits_per_sample(bits_per_sample);
+      ASSERT_EQ(write_file.Write(content), kNoError);
+      ASSERT_EQ(write_file.WriteChunk("note", {'a', 'b', 'c'}), kNoError);
+    }
+    ASSERT_EQ(std::string(big.data(), 4), "RIFX");
+    ASSERT_EQ(big.size(), little.size());
+    // samples bytes are reversed
+    auto bytes_per_sample = bits_per_sample / 8;
+    for (size_t idx = 44; idx < 44 + bytes_per_sample * 100; idx++) {
+      auto sample_start = idx - (idx - 44) % bytes_per_sample;
+      ASSERT_EQ(big[idx], little[2 * sample_start + bytes_per_sample - 1 -
+                                 idx]);
+    }
+
+    File re_read_file;
+    ASSERT_EQ(re_read_file.OpenBuffer(big.data(), big.size()), kNoError);
+    ASSERT_TRUE(re_read_file.big_endian());
+    ASSERT_EQ(re_read_file.bits_per_sample(), bits_per_sample);
+    ASSERT_EQ(re_read_file.frame_number(), read_file.frame_number());
+    std::vector<float> re_read_content;
+    ASSERT_EQ(re_read_file.Read(&re_read_content), kNoError);
+    for (size_t idx = 0; idx < content.size(); idx++) {
+      ASSERT_NEAR(re_read_content[idx], content[idx], 1e-4);
+    }
+    std::vector<char> note;
+    ASSERT_EQ(re_read_file.ReadChunk("note", &note), kNoError);
+    ASSERT_EQ(note, std::vector<char>({'a', 'b', 'c'}));
+
+    // typed reads are swapped as well
+    File little_file;
+    little_file.OpenBuffer(little.data(), little.size());
+    re_read_file.Seek(0);
+    std::vector<int32_t> big_ints, little_ints;
+    ASSERT_EQ(re_read_file.Read(&big_ints), kNoError);
+    ASSERT_EQ(little_file.Read(&little_ints), kNoError);
+    ASSERT_EQ(big_ints, little_ints);
+  }
+}
+
+TEST(Wave, Regions) {
+  using namespace wave;
+  {
+    // two cue points without length, each region extends to the next one
+    File file;
+    ASSERT_EQ(file.Open(gResourcePath + "/extra-header.wav", OpenMode::kIn),
+              kNoError);
+    std::vector<Region> regions;
+    ASSERT_EQ(file.ReadRegionIndex(&regions), kNoError);
+    ASSERT_EQ(regions.size(), 2);
+    ASSERT_EQ(regions[0].id, 1);
+    ASSERT_EQ(regions[0].frame_index, 1000);
+    ASSERT_EQ(regions[0].frame_number, 49000);
+    ASSERT_EQ(regions[1].id, 2);
+    ASSERT_EQ(regions[1].frame_index, 50000);
+    ASSERT_EQ(regions[1].frame_number, file.frame_number() - 50000);
+
+    std::vector<float> region, expected;
+    ASSERT_EQ(file.ReadRegion(1, &region), kNoError);
+    file.Seek(1000);
+    ASSERT_EQ(file.Read(49000, &expected), kNoError);
+    ASSERT_EQ(region, expected);
+    ASSERT_EQ(file.ReadRegion(3, &region), kChunkNotFound);
+
+    File no_cue_file;
+    ASSERT_EQ(
+        no_cue_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn),
+        kNoError);
+    ASSERT_EQ(no_cue_file.ReadRegionIndex(&regions), kChunkNotFound);
+  }
+
+  // overlapping, following and distant regions, one without length
+  std::vector<Region> regions = {
+      {7, 1000, 500, "seventh"}, {3, 0, 100, "third"}, {4, 100, 200, ""},
+      {5, 250, 1000, "fifth"},   {9, 30000, 0, ""},    {8, 20000, 0, "last"}};
+  // labels padded or not
+  regions[1].label = "odd";
+  auto path = gResourcePath + "/output-regions.wav";
+  std::vector<float> content(40000 * 2);
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    content[idx] = static_cast<float>(idx % 1000) / 1000.f;
+  }
+  {
+    File file;
+    ASSERT_EQ(file.Open(path, OpenMode::kOut), kNoError);
+    file.set_channel_number(2);
+    ASSERT_EQ(file.Write(content), kNoError);
+    ASSERT_EQ(file.WriteChunk("cue ", SerializeCuePoints(regions)), kNoError);
+    // the length of 8 isn't stored, it goes up to the next cue point
+    auto stored = regions;
+    stored.erase(stored.begin() + 5);
+    auto list = SerializeAssociatedData(stored);
+    auto label = SerializeAssociatedData({regions[5]});
+    // labl entry only
+    list.insert(list.end(), label.begin() + 4, label.end() - 28);
+    ASSERT_EQ(file.WriteChunk("LIST", list), kNoError);
+  }
+
+  File file;
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  // as stored in file
+  ASSERT_EQ(file.Read(&content), kNoError);
+  std::vector<Region> index;
+  ASSERT_EQ(file.ReadRegionIndex(&index), kNoError);
+  ASSERT_EQ(index.size(), regions.size());
+  std::vector<uint32_t> ids;
+  for (size_t idx = 0; idx < index.size(); idx++) {
+    ids.push_back(index[idx].id);
+    if (idx > 0) {
+      ASSERT_LE(index[idx - 1].frame_index, index[idx].frame_index);
+    }
+  }
+  ASSERT_EQ(ids, std::vector<uint32_t>({3, 4, 5, 7, 8, 9}));
+  ASSERT_EQ(index[0].label, "odd");
+  ASSERT_EQ(index[2].label, "fifth");
+  ASSERT_EQ(index[4].label, "last");
+  ASSERT_EQ(index[4].frame_number, 10000);
+  ASSERT_EQ(index[5].frame_number, 0);
+
+  // in any order, more than once
+  ids = {7, 3, 9, 5, 8, 4, 3};
+  std::vector<std::vector<float>> output;
+  ASSERT_EQ(file.ReadRegions(ids, &output), kNoError);
+  ASSERT_EQ(output.size(), ids.size());
+  for (size_t idx = 0; idx < ids.size(); idx++) {
+    auto region = std::find_if(
+        index.begin(), index.end(),
+        [&](const Region& region) { return region.id == ids[idx]; });
+    auto first = content.begin() + region->frame_index * 2;
+    ASSERT_EQ(output[idx], std::vector<float>(
+                               first, first + region->frame_number * 2));
+  }
+  ASSERT_EQ(file.ReadRegions({3, 6}, &output), kChunkNotFound);
+}
+
+TEST(Wave, Dither) {
+  using namespace wave;
+  // a quiet ramp, most of its values fall between two 16 bits values
+  std::vector<float> content(20000);
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    content[idx] = 0.001f * static_cast<float>(idx % 1000) / 1000.f;
+  }
+  auto write = [&](Dither dither, uint64_t seed, uint16_t bits_per_sample,
+                   size_t block_size, std::vector<char>* buffer) {
+    File file;
+    file.OpenBuffer(buffer, OpenMode::kOut);
+    file.set_channel_number(2);
+    file.set_bits_per_sample(bits_per_sample);
+    file.set_dither(dither, seed);
+    for (size_t first = 0; first < content.size(); first += block_size) {
+      auto last = std::min(first + block_size, content.size());
+      ASSERT_EQ(file.Write(std::vector<float>(content.begin() + first,
+                                              content.begin() + last)),
+                kNoError);
+    }
+  };
+  auto read = [](std::vector<char>* buffer, std::vector<int16_t>* output) {
+    File file;
+    ASSERT_EQ(file.OpenBuffer(buffer->data(), buffer->size()), kNoError);
+    ASSERT_EQ(file.Read(output), kNoError);
+  };
+
+  std::vector<char> plain, dithered, split, other_seed, shaped, deep,
+      deep_plain;
+  write(kNoDither, 0, 16, content.size(), &plain);
+  write(kTPDFDither, 1, 16, content.size(), &dithered);
+  // the noise of a sample doesn't depend on how writes are split
+  write(kTPDFDither, 1, 16, 998, &split);
+  write(kTPDFDither, 2, 16, content.size(), &other_seed);
+  ASSERT_EQ(dithered, split);
+  ASSERT_NE(dithered, other_seed);
+  ASSERT_NE(dithered, plain);
+
+  // within one least significant bit of the input, noise averages out
+  std::vector<int16_t> samples;
+  read(&dithered, &samples);
+  ASSERT_EQ(samples.size(), content.size());
+  double error_sum = 0;
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    auto error = samples[idx] - content[idx] * 32767.;
+    ASSERT_LT(std::abs(error), 1.5);
+    error_sum += error;
+  }
+  ASSERT_LT(std::abs(error_sum / content.size()), 0.05);
+
+  // noise shaping keeps the error of each channel bounded
+  write(kNoiseShapedDither, 1, 16, 998, &shaped);
+  read(&shaped, &samples);
+  ASSERT_EQ(samples.size(), content.size());
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    ASSERT_LT(std::abs(samples[idx] - content[idx] * 32767.), 3.);
+  }
+
+  // no dither beyond 16 bits
+  write(kTPDFDither, 1, 24, content.size(), &deep);
+  write(kNoDither, 0, 24, content.size(), &deep_plain);
+  ASSERT_EQ(deep, deep_plain);
+}
+
+TEST(Wave, TrailingChunks) {
+  using namespace wave;
+  std::vector<float> content(2000);
+  for (size_t idx = 0; idx < content.size(); idx++) {
+    content[idx] = static_cast<float>(idx % 100) / 100.f;
+  }
+  // many chunks after the samples, only listed when asked for
+  std::vector<char> buffer;
+  {
+    File file;
+    file.OpenBuffer(&buffer, OpenMode::kOut);
+    file.set_channel_number(2);
+    ASSERT_EQ(file.Write(content), kNoError);
+    for (int idx = 0; idx < 500; idx++) {
+      auto id = "c" + std::to_string(100 + idx);
+      ASSERT_EQ(file.WriteChunk(id, std::vector<char>(idx, 'a')), kNoError);
+    }
+  }
+  File file;
+  ASSERT_EQ(file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  std::vector<float> output;
+  ASSERT_EQ(file.Read(&output), kNoError);
+  ASSERT_EQ(output.size(), content.size());
+  std::vector<char> chunk;
+  ASSERT_EQ(file.ReadChunk("c599", &chunk), kNoError);
+  ASSERT_EQ(chunk, std::vector<char>(499, 'a'));
+  auto ids = file.chunk_ids();
+  ASSERT_EQ(ids.size(), 500);
+  ASSERT_EQ(ids.front(), "c100");
+  ASSERT_EQ(ids.back(), "c599");
+
+  // appended samples go in front of them
+  {
+    File append_file;
+    ASSERT_EQ(append_file.OpenBuffer(&buffer, OpenMode::kAppend), kNoError);
+    ASSERT_EQ(append_file.Write(content), kNoError);
+  }
+  ASSERT_EQ(file.OpenBuffer(buffer.data(), buffer.size()), kNoError);
+  ASSERT_EQ(file.frame_number(), content.size());
+  ASSERT_EQ(file.chunk_ids().size(), 500);
+  ASSERT_EQ(file.ReadChunk("c150", &chunk), kNoError);
+  ASSERT_EQ(chunk, std::vector<char>(50, 'a'));
+
+  // headers beyond the first block read at once
+  std::vector<char> padded(buffer.begin(), buffer.begin() + 12);
+  std::vector<char> junk = {'J', 'U', 'N', 'K', 0x10, 0x27, 0, 0};
+  padded.insert(padded.end(), junk.begin(), junk.end());
+  padded.resize(padded.size() + 10000, 0);
+  padded.insert(padded.end(), buffer.begin() + 12, buffer.end());
+  uint32_t riff_size = static_cast<uint32_t>(padded.size() - 8);
+  memcpy(padded.data() + 4, &riff_size, sizeof(riff_size));
+  ASSERT_EQ(file.OpenBuffer(padded.data(), padded.size()), kNoError);
+  ASSERT_EQ(file.frame_number(), content.size());
+  ASSERT_EQ(file.Read(&output), kNoError);
+  ASSERT_EQ(std::vector<float>(output.begin(), output.begin() + 2000),
+            std::vector<float>(output.begin() + 2000, output.end()));
+  ASSERT_EQ(file.chunk_ids().size(), 500);
+}
+
+TEST(Wave, WriteAt) {
+  using namespace wave;
+  File read_file;
+  ASSERT_EQ(read_file.Open(gResourcePath + "/Untitled3.wav", OpenMode::kIn),
+            kNoError);
+  std::vector<float> content;
+  ASSERT_EQ(read_file.Read(&content), kNoError);
+  auto frame_number = read_file.frame_number();
+
+  // written at once as a reference, with dither to check its noise too
+  std::vector<char> reference;
+  {
+    File file;
+    file.OpenBuffer(&reference, OpenMode::kOut);
+    file.set_channel_number(2);
+    file.set_dither(kTPDFDither, 3);
+    ASSERT_EQ(file.Write(content), kNoError);
+  }
+
+  // blocks written from several threads, in any order
+  auto write = [&](File* file) {
+    file->set_channel_number(2);
+    file->set_dither(kTPDFDither, 3);
+    file->set_expected_frame_number(frame_number);
+    const uint64_t kBlockFrameNumber = 10000;
+    const int kThreadNumber = 4;
+    uint64_t block_number =
+        (frame_number + kBlockFrameNumber - 1) / kBlockFrameNumber;
+    std::vector<Error> errors(kThreadNumber, kNoError);
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kThreadNumber; thread++) {
+      threads.emplace_back([&, thread]() {
+        for (uint64_t idx = thread; idx < block_number;
+             idx += kThreadNumber) {
+          auto block = block_number - 1 - idx;
+          auto first = block * kBlockFrameNumber;
+          auto last = std::min(first + kBlockFrameNumber, frame_number);
+          auto error = file->WriteAt(
+              first, std::vector<float>(content.begin() + first * 2,
+                                        content.begin() + last * 2));
+          if (error != kNoError) {
+            errors[thread] = error;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    ASSERT_EQ(errors, std::vector<Error>(kThreadNumber, kNoError));
+    ASSERT_EQ(file->frame_number(), frame_number);
+    ASSERT_EQ(file->Tell(), 0);
+  };
+
+  auto path = gResourcePath + "/output-parallel.wav";
+  {
+    File file;
+    ASSERT_EQ(file.Open(path, OpenMode::kOut), kNoError);
+    write(&file);
+  }
+  std::ifstream stream(path, std::ios::binary);
+  ASSERT_EQ(std::vector<char>((std::istreambuf_iterator<char>(stream)),
+                              std::istreambuf_iterator<char>()),
+            reference);
+
+  std::vector<char> buffer;
+  {
+    File file;
+    file.OpenBuffer(&buffer, OpenMode::kOut);
+    write(&file);
+  }
+  ASSERT_EQ(buffer, reference);
+
+  // the header is fixed on Close when fewer frames are written
+  {
+    File file;
+    ASSERT_EQ(file.Open(path, OpenMode::kOut), kNoError);
+    file.set_channel_number(2);
+    file.set_expected_frame_number(2 * frame_number);
+    ASSERT_EQ(file.Write(content), kNoError);
+    ASSERT_EQ(file.WriteAt(3 * frame_number / 2, {0.5f, 0.5f}),
+              kNoError);
+    ASSERT_EQ(file.frame_number(), 3 * frame_number / 2 + 1);
+    ASSERT_EQ(file.WriteAt(2 * frame_number, {0.5f, 0.5f}), kInvalidFormat);
+    ASSERT_EQ(file.WriteAt(0, {0.5f}), kInvalidFormat);
+  }
+  ASSERT_EQ(read_file.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_EQ(read_file.frame_number(), 3 * frame_number / 2 + 1);
+  std::vector<float> output;
+  ASSERT_EQ(read_file.Read(frame_number, &output), kNoError);
+  ASSERT_EQ(output, content);
+  ASSERT_EQ(read_file.WriteAt(0, {0.f, 0.f}), kNotOpen);
+
+  // the expected frame number is needed
+  File file;
+  file.OpenBuffer(&buffer, OpenMode::kOut);
+  ASSERT_EQ(file.WriteAt(0, {0.f}), kInvalidFormat);
+}
+
+TEST(Wave, Close) {
+  using namespace wave;
+  std::vector<float> content(1000, 0.5f);
+  auto path = gResourcePath + "/output-close.wav";
+  File file;
+  ASSERT_EQ(file.Close(), kNoError);
+  ASSERT_EQ(file.Open(path, OpenMode::kOut), kNoError);
+  file.set_channel_number(2);
+  file.set_expected_frame_number(1000);
+  ASSERT_EQ(file.Write(content), kNoError);
+  ASSERT_EQ(file.WriteChunk("abcd", std::vector<char>(3, 'a')), kNoError);
+  ASSERT_EQ(file.Close(), kNoError);
+  ASSERT_EQ(file.Write(content), kNotOpen);
+
+  // the expected frame number was not reached, the header is fixed on Close
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  ASSERT_EQ(file.frame_number(), 500);
+  std::vector<char> chunk;
+  ASSERT_EQ(file.ReadChunk("abcd", &chunk), kNoError);
+  ASSERT_EQ(chunk, std::vector<char>(3, 'a'));
+
+#ifdef __linux__
+  // failures to write what is left are reported
+  ASSERT_EQ(file.Open("/dev/full", OpenMode::kOut), kNoError);
+  ASSERT_EQ(file.WriteChunk("abcd", std::vector<char>(3, 'a')), kNoError);
+  ASSERT_EQ(file.Close(), kWriteError);
+  // direct writes are done on Close
+  ASSERT_EQ(file.OpenDirect("/dev/full"), kNoError);
+  ASSERT_EQ(file.Write(content), kNoError);
+  ASSERT_EQ(file.Close(), kWriteError);
+#endif  // __linux__
+}
+
 TEST(Wave, FormatError) {
   using namespace wave;
   File file;
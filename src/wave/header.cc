@@ -1,40 +1,120 @@
 #include "wave/header.h"
 
+#include <cstring>
+
+#include "wave/byte_order.h"
 #include "wave/header/riff_header.h"
 
 namespace wave {
-  Error Header::Init(std::ifstream* stream, uint64_t position) {
+
+const uint32_t Header::kSize;
+
+  Error Header::Init(Stream* stream, uint64_t position, bool big_endian) {
     position_ = position;
     if (!stream->is_open()) {
       return Error::kNotOpen;
     }
 
-    // read chunk ID
-    const auto chunk_id_size = 4;
-    stream->seekg(position_, std::ios::beg);
-    char result[chunk_id_size];
-    stream->read(result, chunk_id_size * sizeof(char));
-    id_ = std::string(result, chunk_id_size);
-
-    // and size
-    stream->read(reinterpret_cast<char*>(&size_), sizeof(uint32_t));
-    size_ += chunk_id_size * sizeof(char) + sizeof(uint32_t);
-
+    // chunk ID and size in a single read
+    char data[kSize] = {0};
+    stream->Seek(position_);
+    stream->Read(data, kSize);
+    Init(data, position, big_endian);
     return Error::kNoError;
   }
 
+  void Header::Init(const char* data, uint64_t position, bool big_endian) {
+    position_ = position;
+    const auto chunk_id_size = 4;
+    id_ = std::string(data, chunk_id_size);
+    memcpy(&content_size_, data + chunk_id_size, sizeof(uint32_t));
+    content_size_ = internal::FromFileOrder(content_size_, big_endian);
+    // chunks are padded to an even size
+    size_ = static_cast<uint64_t>(kSize) + content_size_ + (content_size_ & 1);
+  }
+
 std::string Header::chunk_id() const {
   return id_;
 }
 
-uint32_t Header::chunk_size() const {
-  if (chunk_id() == "RIFF") {
+uint64_t Header::chunk_size() const {
+  if (chunk_id() == "RIFF" || chunk_id() == "RIFX") {
     return sizeof(wave::RIFFHeader);
   }
   return size_;
 }
 
+uint32_t Header::content_size() const {
+  return content_size_;
+}
+
 uint64_t Header::position() const {
   return position_;
 }
+
+const uint64_t ChunkWalker::kBlockSize;
+
+ChunkWalker::ChunkWalker()
+    : block_size_(0), file_size_(0), big_endian_(false) {}
+
+uint64_t ChunkWalker::Open(ReadFunction read, uint64_t file_size) {
+  read_ = read;
+  file_size_ = file_size;
+  block_size_ = read_(0, block_, kBlockSize);
+  big_endian_ = block_size_ >= 4 && memcmp(block_, "RIFX", 4) == 0;
+  return block_size_;
+}
+
+void ChunkWalker::Clear() { block_size_ = 0; }
+
+bool ChunkWalker::Read(uint64_t position, char* data, uint64_t size) const {
+  if (position + size <= block_size_) {
+    memcpy(data, block_ + position, size);
+    return true;
+  }
+  return read_ && read_(position, data, size) == size;
+}
+
+bool ChunkWalker::ReadHeader(uint64_t position, Header* chunk) const {
+  char data[Header::kSize];
+  if (!Read(position, data, Header::kSize)) {
+    return false;
+  }
+  chunk->Init(data, position, big_endian_);
+  return true;
+}
+
+Error ChunkWalker::FindFormat(FMTHeader* fmt, Header* data) const {
+  RIFFHeader riff;
+  if (!Read(0, reinterpret_cast<char*>(&riff), sizeof(riff)) ||
+      (std::string(riff.chunk_id, 4) != "RIFF" &&
+       std::string(riff.chunk_id, 4) != "RIFX") ||
+      std::string(riff.format, 4) != "WAVE") {
+    return Error::kInvalidFormat;
+  }
+  bool has_fmt = false;
+  bool has_data = false;
+  uint64_t position = sizeof(riff);
+  Header chunk;
+  while ((!has_fmt || !has_data) && ReadHeader(position, &chunk)) {
+    if (chunk.chunk_id() == "fmt " && !has_fmt) {
+      if (!Read(position, reinterpret_cast<char*>(fmt), sizeof(*fmt))) {
+        return Error::kInvalidFormat;
+      }
+      ConvertByteOrder(big_endian_, fmt);
+      has_fmt = true;
+    } else if (chunk.chunk_id() == "data" && !has_data) {
+      *data = chunk;
+      has_data = true;
+    }
+    // the chunk ends past the file, which is truncated or corrupted
+    if (position + chunk.chunk_size() > file_size_) {
+      break;
+    }
+    position += chunk.chunk_size();
+  }
+  return has_fmt && has_data ? Error::kNoError : Error::kInvalidFormat;
+}
+
+bool ChunkWalker::big_endian() const { return big_endian_; }
 };  // namespace wave
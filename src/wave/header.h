@@ -1,25 +1,112 @@
 #ifndef WAVE_WAVE_HEADER_H_
 #define WAVE_WAVE_HEADER_H_
 
-#include <fstream>
 #include <cstdint>
+#include <functional>
+#include <string>
 
 #include "wave/error.h"
+#include "wave/header/fmt_header.h"
+#include "wave/stream.h"
 
 namespace wave {
 
 class Header {
  public:
-  Error Init(std::ifstream* stream, uint64_t position);
+  // size of chunk ID and size
+  static const uint32_t kSize = 8;
+
+  /**
+   * @brief Read the chunk header at position. Sizes are big-endian when
+   * big_endian is set, in RIFX files.
+   */
+  Error Init(Stream* stream, uint64_t position, bool big_endian = false);
+  /**
+   * @brief Parse the chunk header of position from its 8 bytes, already read
+   * in data.
+   */
+  void Init(const char* data, uint64_t position, bool big_endian = false);
   std::string chunk_id() const;
-  uint32_t chunk_size() const;
+  /**
+   * @brief Size of the whole chunk, header and padding included. Computed on
+   * 64 bits, sizes close to 4 GiB don't wrap around.
+   */
+  uint64_t chunk_size() const;
+  /**
+   * @brief Size of the chunk content, without ID, size and padding
+   */
+  uint32_t content_size() const;
   uint64_t position() const;
 
  private:
   std::string id_;
-  uint32_t size_;
+  uint64_t size_;
+  uint32_t content_size_;
   uint64_t position_;
 };
+
+/**
+ * @brief Reads the chunk headers of a RIFF file. The beginning of the file is
+ * read at once, which gives the headers in front of the samples of most
+ * files, the ones beyond it are read from the file.
+ */
+class ChunkWalker {
+ public:
+  // number of bytes read at once from the beginning of the file
+  static const uint64_t kBlockSize = 4096;
+
+  /**
+   * @brief Read up to size bytes of the file at position.
+   * @return the number of bytes actually read
+   */
+  typedef std::function<uint64_t(uint64_t position, char* data, uint64_t size)>
+      ReadFunction;
+
+  ChunkWalker();
+
+  /**
+   * @brief Start walking a file of file_size bytes, of which bytes are read
+   * with read.
+   * @return the number of bytes read at once, less than kBlockSize for
+   * smaller files
+   */
+  uint64_t Open(ReadFunction read, uint64_t file_size);
+  /**
+   * @brief Forget the beginning of the file read by Open, once the file
+   * changed. Everything is read from the file from then on.
+   */
+  void Clear();
+
+  /**
+   * @brief Copy size bytes at position, from the beginning of the file read
+   * by Open when possible.
+   */
+  bool Read(uint64_t position, char* data, uint64_t size) const;
+  /**
+   * @brief Read the header of the chunk at position.
+   * @return false if the file ends before the header
+   */
+  bool ReadHeader(uint64_t position, Header* chunk) const;
+  /**
+   * @brief Find the first "fmt " and "data" chunks, which come first in most
+   * files. fmt is returned in native byte order. The walk stops at the first
+   * chunk that ends past the file.
+   * @return kInvalidFormat if the file isn't a WAVE file or lacks one of them
+   */
+  Error FindFormat(FMTHeader* fmt, Header* data) const;
+
+  /**
+   * @brief Whether sizes are big-endian, in RIFX files
+   */
+  bool big_endian() const;
+
+ private:
+  ReadFunction read_;
+  char block_[kBlockSize];
+  uint64_t block_size_;
+  uint64_t file_size_;
+  bool big_endian_;
+};
   
 }  // namespace wave
 
@@ -2,10 +2,17 @@
 
 #include <cstring>
 
+#include "wave/byte_order.h"
+
 namespace wave {
 DataHeader MakeDataHeader() {
   DataHeader header;
   strncpy(header.sub_chunk_2_id, "data", 4);
   return header;
 }
+
+void ConvertByteOrder(bool big_endian, DataHeader* header) {
+  header->sub_chunk_2_size =
+      internal::FromFileOrder(header->sub_chunk_2_size, big_endian);
+}
 }  // namespace wave
@@ -10,6 +10,7 @@ struct DataHeader {
   uint32_t sub_chunk_2_size;
 };
 DataHeader MakeDataHeader();
+void ConvertByteOrder(bool big_endian, DataHeader* header);
 
 }  // namespace wave
 
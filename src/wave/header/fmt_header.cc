@@ -2,6 +2,8 @@
 
 #include <cstring>
 
+#include "wave/byte_order.h"
+
 namespace wave {
 FMTHeader MakeFMTHeader() {
   FMTHeader header;
@@ -16,4 +18,17 @@ FMTHeader MakeFMTHeader() {
   header.byte_rate = header.byte_per_block * header.sample_rate;
   return header;
 }
+
+void ConvertByteOrder(bool big_endian, FMTHeader* header) {
+  using internal::FromFileOrder;
+  header->sub_chunk_1_size =
+      FromFileOrder(header->sub_chunk_1_size, big_endian);
+  header->audio_format = FromFileOrder(header->audio_format, big_endian);
+  header->num_channel = FromFileOrder(header->num_channel, big_endian);
+  header->sample_rate = FromFileOrder(header->sample_rate, big_endian);
+  header->byte_rate = FromFileOrder(header->byte_rate, big_endian);
+  header->byte_per_block = FromFileOrder(header->byte_per_block, big_endian);
+  header->bits_per_sample =
+      FromFileOrder(header->bits_per_sample, big_endian);
+}
 }  // namespace wave
@@ -16,6 +16,7 @@ struct FMTHeader {
   uint16_t bits_per_sample;
 };
 FMTHeader MakeFMTHeader();
+void ConvertByteOrder(bool big_endian, FMTHeader* header);
 
 }  // namespace wave
 
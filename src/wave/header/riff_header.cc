@@ -2,6 +2,8 @@
 
 #include <cstring>
 
+#include "wave/byte_order.h"
+
 namespace wave {
 
 RIFFHeader MakeRIFFHeader() {
@@ -10,4 +12,8 @@ RIFFHeader MakeRIFFHeader() {
   strncpy(header.format, "WAVE", 4);
   return header;
 }
+
+void ConvertByteOrder(bool big_endian, RIFFHeader* header) {
+  header->chunk_size = internal::FromFileOrder(header->chunk_size, big_endian);
+}
 }  // namespace wave
@@ -11,6 +11,11 @@ struct RIFFHeader {
   char format[4];
 };
 RIFFHeader MakeRIFFHeader();
+/**
+ * @brief Convert the fields of header between host order and the byte order
+ * of a file, big-endian for RIFX files. Converting twice gives header back.
+ */
+void ConvertByteOrder(bool big_endian, RIFFHeader* header);
 
 }  // namespace wave
 
@@ -8,4 +8,10 @@ WAVEHeader MakeWAVEHeader() {
   header.data = MakeDataHeader();
   return header;
 }
+
+void ConvertByteOrder(bool big_endian, WAVEHeader* header) {
+  ConvertByteOrder(big_endian, &header->riff);
+  ConvertByteOrder(big_endian, &header->fmt);
+  ConvertByteOrder(big_endian, &header->data);
+}
 }  // namespace wave
@@ -13,6 +13,8 @@ struct WAVEHeader {
   DataHeader data;
 };
 WAVEHeader MakeWAVEHeader();
+// all the headers, see ConvertByteOrder(bool, RIFFHeader*)
+void ConvertByteOrder(bool big_endian, WAVEHeader* header);
 
 }  // namespace wave
 
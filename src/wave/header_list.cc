@@ -1,14 +1,18 @@
 #include "wave/header_list.h"
 
+#include <algorithm>
+
 namespace wave {
 
-HeaderList::Iterator::Iterator(std::ifstream* stream, uint64_t position)
-    : stream_(stream), position_(position) {}
+HeaderList::Iterator::Iterator(Stream* stream, uint64_t position,
+                               bool big_endian)
+    : stream_(stream), position_(position), big_endian_(big_endian) {}
 
 HeaderList::Iterator HeaderList::Iterator::operator++() {
   Header h;
-  h.Init(stream_, position_);
-  position_ += h.chunk_size();
+  h.Init(stream_, position_, big_endian_);
+  // a chunk ending past the file is the last one, which ends the iteration
+  position_ = std::min(position_ + h.chunk_size(), stream_->Size());
   return *this;
 }
 
@@ -22,7 +26,7 @@ HeaderList::Iterator HeaderList::Iterator::operator++(int) {
 
 Header HeaderList::Iterator::operator*() {
   Header h;
-  h.Init(stream_, position_);
+  h.Init(stream_, position_, big_endian_);
   return h;
 }
 
@@ -33,27 +37,41 @@ bool HeaderList::Iterator::operator!=(const Iterator& rhs) {
   return !operator==(rhs);
 }
 
+HeaderList::HeaderList() : stream_(nullptr), big_endian_(false) {}
+
 Error HeaderList::Init(const std::string& path) {
-  stream_.open(path.c_str(), std::ios::binary);
-  if (!stream_.is_open()) {
+  owned_stream_.reset(new FileStream());
+  auto error = owned_stream_->Open(path, std::ios::in);
+  if (error != Error::kNoError) {
+    return error;
+  }
+  return Init(owned_stream_.get());
+}
+
+Error HeaderList::Init(Stream* stream) {
+  stream_ = stream;
+  if (!stream_->is_open()) {
     return Error::kFailedToOpen;
   }
+  // RIFX files store sizes big-endian
+  char riff_id[4] = {0};
+  stream_->Seek(0);
+  stream_->Read(riff_id, sizeof(riff_id));
+  big_endian_ = std::string(riff_id, sizeof(riff_id)) == "RIFX";
   return Error::kNoError;
 }
 
 HeaderList::Iterator HeaderList::begin() {
-  return HeaderList::Iterator(&stream_, 0);
+  return HeaderList::Iterator(stream_, 0, big_endian_);
 }
 
 HeaderList::Iterator HeaderList::end() {
-  stream_.seekg(0, std::ios::end);
-  uint64_t size = stream_.tellg();
-  stream_.seekg(0, std::ios::beg);
-  return HeaderList::Iterator(&stream_, size);
+  return HeaderList::Iterator(stream_, stream_->Size(), big_endian_);
 }
 
 Header HeaderList::header(const std::string& header_id) {
-  for (auto iterator = begin(); iterator != end(); iterator++) {
+  auto last = end();
+  for (auto iterator = begin(); iterator != last; iterator++) {
     auto header = *iterator;
     if (header.chunk_id() == header_id) {
       return header;
@@ -62,7 +80,9 @@ Header HeaderList::header(const std::string& header_id) {
   return *begin();
 }
 
-Header HeaderList::riff() { return header("RIFF"); }
+bool HeaderList::big_endian() const { return big_endian_; }
+
+Header HeaderList::riff() { return header(big_endian_ ? "RIFX" : "RIFF"); }
 Header HeaderList::fmt() { return header("fmt "); }
 Header HeaderList::data() { return header("data"); }
 
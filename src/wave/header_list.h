@@ -1,10 +1,13 @@
 #ifndef WAVE_WAVE_HEADER_LIST_H_
 #define WAVE_WAVE_HEADER_LIST_H_
 
-#include <fstream>
+#include <memory>
+#include <string>
 
 #include "wave/header.h"
 #include "wave/error.h"
+#include "wave/stream.h"
+#include "wave/stream/file_stream.h"
 
 namespace wave {
 
@@ -12,20 +15,33 @@ class HeaderList {
  public:
   class Iterator {
    public:
-    Iterator(std::ifstream* stream, uint64_t position);
+    Iterator(Stream* stream, uint64_t position, bool big_endian = false);
     Iterator operator++();
     Iterator operator++(int);
     Header operator*();
     bool operator==(const Iterator& rhs);
     bool operator!=(const Iterator& rhs);
    private:
-    std::ifstream* stream_;
+    Stream* stream_;
     uint64_t position_;
+    bool big_endian_;
   };
 
+  HeaderList();
+
   Error Init(const std::string& path);
+  /**
+   * @brief Iterate over an already opened stream instead of opening the file
+   * a second time. The stream has to outlive the list.
+   */
+  Error Init(Stream* stream);
   Iterator begin();
   Iterator end();
+
+  /**
+   * @brief Whether sizes are big-endian, in RIFX files
+   */
+  bool big_endian() const;
   
   Header riff();
   Header fmt();
@@ -33,7 +49,9 @@ class HeaderList {
   
  private:
   Header header(const std::string& header_id);
-  std::ifstream stream_;
+  std::unique_ptr<FileStream> owned_stream_;
+  Stream* stream_;
+  bool big_endian_;
 };
 }  // namespace wave
 
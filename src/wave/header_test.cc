@@ -1,6 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "wave/file.h"
 #include "wave/header_list.h"
+#include "wave/stream/memory_stream.h"
 
 const std::string gResourcePath(TEST_RESOURCES_PATH);
 
@@ -34,3 +41,92 @@ TEST(Header, List) {
   ASSERT_EQ((*iterator).chunk_id(), "bext");
   ASSERT_EQ((*iterator).chunk_size(), 866);
 }
+
+TEST(Header, Walker) {
+  using namespace wave;
+  std::ifstream stream(gResourcePath + "/extra-header.wav", std::ios::binary);
+  std::vector<char> content((std::istreambuf_iterator<char>(stream)),
+                            std::istreambuf_iterator<char>());
+  uint64_t read_number = 0;
+  auto read = [&](uint64_t position, char* data, uint64_t size) -> uint64_t {
+    read_number++;
+    if (position >= content.size()) {
+      return 0;
+    }
+    size = std::min<uint64_t>(size, content.size() - position);
+    memcpy(data, content.data() + position, size);
+    return size;
+  };
+
+  ChunkWalker walker;
+  ASSERT_EQ(walker.Open(read, content.size()), ChunkWalker::kBlockSize);
+  ASSERT_FALSE(walker.big_endian());
+  FMTHeader fmt;
+  Header data;
+  ASSERT_EQ(walker.FindFormat(&fmt, &data), kNoError);
+  ASSERT_EQ(fmt.num_channel, 2);
+  ASSERT_EQ(data.position(), 96);
+  ASSERT_EQ(data.chunk_size(), 38725764);
+  // the headers in front of the samples come from the first block
+  ASSERT_EQ(read_number, 1);
+
+  // the ones after the samples from the file
+  Header chunk;
+  ASSERT_TRUE(walker.ReadHeader(data.position() + data.chunk_size(), &chunk));
+  ASSERT_EQ(chunk.chunk_id(), "bext");
+  ASSERT_EQ(read_number, 2);
+  ASSERT_FALSE(walker.ReadHeader(content.size(), &chunk));
+
+  // not a WAVE file
+  content.assign(100, 0);
+  ASSERT_EQ(walker.Open(read, content.size()), 100);
+  ASSERT_EQ(walker.FindFormat(&fmt, &data), kInvalidFormat);
+}
+
+TEST(Header, WrappingSize) {
+  using namespace wave;
+  // a JUNK chunk in front of "fmt " with a size that wraps around on 32 bits
+  // once the header and padding are added
+  for (uint32_t junk_size : {0xfffffff7u, 0xfffffff8u}) {
+    std::vector<char> content(60, 0);
+    memcpy(content.data(), "RIFF", 4);
+    uint32_t riff_size = 52;
+    memcpy(content.data() + 4, &riff_size, 4);
+    memcpy(content.data() + 8, "WAVE", 4);
+    memcpy(content.data() + 12, "JUNK", 4);
+    memcpy(content.data() + 16, &junk_size, 4);
+
+    Header junk;
+    junk.Init(content.data() + 12, 12);
+    ASSERT_EQ(junk.chunk_size(), 0x100000000);
+
+    ChunkWalker walker;
+    walker.Open(
+        [&](uint64_t position, char* data, uint64_t size) -> uint64_t {
+          if (position >= content.size()) {
+            return 0;
+          }
+          size = std::min<uint64_t>(size, content.size() - position);
+          memcpy(data, content.data() + position, size);
+          return size;
+        },
+        content.size());
+    FMTHeader fmt;
+    Header data;
+    ASSERT_EQ(walker.FindFormat(&fmt, &data), kInvalidFormat);
+
+    MemoryStream stream;
+    stream.Open(content.data(), content.size());
+    HeaderList list;
+    ASSERT_EQ(list.Init(&stream), kNoError);
+    std::vector<std::string> ids;
+    for (auto header : list) {
+      ids.push_back(header.chunk_id());
+    }
+    ASSERT_EQ(ids, std::vector<std::string>({"RIFF", "JUNK"}));
+
+    File file;
+    ASSERT_EQ(file.OpenBuffer(content.data(), content.size()),
+              kInvalidFormat);
+  }
+}
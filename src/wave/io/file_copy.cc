@@ -0,0 +1,168 @@
+#include "wave/io/file_copy.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif  // _WIN32
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif  // __linux__
+
+namespace wave {
+
+namespace {
+
+// size of the blocks of the buffered copy
+const size_t kCopyBlockSize = 1 << 20;
+
+#ifdef __linux__
+// Copy by the kernel, without going through user space. Returns the number
+// of bytes copied, which may be short if the kernel can't copy between
+// these files
+uint64_t KernelCopy(int input, uint64_t input_offset, int output,
+                    uint64_t output_offset, uint64_t size) {
+  uint64_t copied = 0;
+#ifdef WAVE_HAVE_COPY_FILE_RANGE
+  loff_t in_offset = input_offset;
+  loff_t out_offset = output_offset;
+  while (copied < size) {
+    auto result = copy_file_range(input, &in_offset, output, &out_offset,
+                                  size - copied, 0);
+    if (result <= 0) {
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    copied += result;
+  }
+  if (copied == size) {
+    return copied;
+  }
+#endif  // WAVE_HAVE_COPY_FILE_RANGE
+  // sendfile writes at the current position of output
+  if (lseek(output, output_offset + copied, SEEK_SET) < 0) {
+    return copied;
+  }
+  off_t offset = input_offset + copied;
+  while (copied < size) {
+    auto result = sendfile(output, input, &offset, size - copied);
+    if (result <= 0) {
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    copied += result;
+  }
+  return copied;
+}
+#endif  // __linux__
+
+uint64_t TellFile(FILE* file) {
+#ifdef _WIN32
+  return _ftelli64(file);
+#else
+  return ftello(file);
+#endif  // _WIN32
+}
+
+#ifdef _WIN32
+bool FileIdentity(const std::string& path, BY_HANDLE_FILE_INFORMATION* info) {
+  auto handle = CreateFileA(path.c_str(), 0,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE |
+                                FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  auto found = GetFileInformationByHandle(handle, info) != 0;
+  CloseHandle(handle);
+  return found;
+}
+#endif  // _WIN32
+
+}  // namespace
+
+int SeekFile(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+  return _fseeki64(file, offset, SEEK_SET);
+#else
+  return fseeko(file, offset, SEEK_SET);
+#endif  // _WIN32
+}
+
+uint64_t FileSize(FILE* file) {
+  auto position = TellFile(file);
+#ifdef _WIN32
+  _fseeki64(file, 0, SEEK_END);
+#else
+  fseeko(file, 0, SEEK_END);
+#endif  // _WIN32
+  auto size = TellFile(file);
+  SeekFile(file, position);
+  return size;
+}
+
+uint64_t ReadFile(FILE* file, uint64_t offset, char* data, uint64_t size) {
+  if (SeekFile(file, offset) != 0) {
+    return 0;
+  }
+  return fread(data, 1, size, file);
+}
+
+bool SameFile(const std::string& path, const std::string& other_path) {
+#ifdef _WIN32
+  BY_HANDLE_FILE_INFORMATION info, other_info;
+  return FileIdentity(path, &info) && FileIdentity(other_path, &other_info) &&
+         info.dwVolumeSerialNumber == other_info.dwVolumeSerialNumber &&
+         info.nFileIndexHigh == other_info.nFileIndexHigh &&
+         info.nFileIndexLow == other_info.nFileIndexLow;
+#else
+  struct stat info, other_info;
+  return stat(path.c_str(), &info) == 0 &&
+         stat(other_path.c_str(), &other_info) == 0 &&
+         info.st_dev == other_info.st_dev && info.st_ino == other_info.st_ino;
+#endif  // _WIN32
+}
+
+bool CopyFileRange(FILE* input, uint64_t input_offset, FILE* output,
+                   uint64_t size) {
+  if (fflush(output) != 0) {
+    return false;
+  }
+  uint64_t output_offset = TellFile(output);
+  uint64_t copied = 0;
+#ifdef __linux__
+  copied = KernelCopy(fileno(input), input_offset, fileno(output),
+                      output_offset, size);
+#endif  // __linux__
+  // whatever the kernel couldn't copy goes through a buffer
+  if (SeekFile(input, input_offset + copied) != 0 ||
+      SeekFile(output, output_offset + copied) != 0) {
+    return false;
+  }
+  if (copied == size) {
+    return true;
+  }
+  std::vector<char> buffer(std::min<uint64_t>(kCopyBlockSize, size - copied));
+  while (copied < size) {
+    auto block_size = std::min<uint64_t>(buffer.size(), size - copied);
+    if (fread(buffer.data(), 1, block_size, input) != block_size ||
+        fwrite(buffer.data(), 1, block_size, output) != block_size) {
+      return false;
+    }
+    copied += block_size;
+  }
+  return true;
+}
+
+}  // namespace wave
@@ -0,0 +1,46 @@
+#ifndef WAVE_IO_FILE_COPY_H_
+#define WAVE_IO_FILE_COPY_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace wave {
+
+/**
+ * @brief fseek on 64 bits offsets
+ */
+int SeekFile(FILE* file, uint64_t offset);
+
+/**
+ * @brief Size of file in bytes, its position is kept
+ */
+uint64_t FileSize(FILE* file);
+
+/**
+ * @brief Read up to size bytes found at offset in file.
+ * @return the number of bytes actually read
+ */
+uint64_t ReadFile(FILE* file, uint64_t offset, char* data, uint64_t size);
+
+/**
+ * @brief Whether path and other_path are the same existing file, whatever
+ * the way they are spelled (relative, through ".." or links).
+ * @note: Files are compared by device and inode number, by volume serial
+ * number and file index on Windows. A path that doesn't exist is no file.
+ */
+bool SameFile(const std::string& path, const std::string& other_path);
+
+/**
+ * @brief Copy size bytes found at input_offset in input to the current
+ * position of output, which moves forward.
+ * @note: The copy is done by the kernel where supported (copy_file_range or
+ * sendfile on Linux), by large buffered blocks otherwise. Memory use doesn't
+ * depend on size.
+ */
+bool CopyFileRange(FILE* input, uint64_t input_offset, FILE* output,
+                   uint64_t size);
+
+}  // namespace wave
+
+#endif  // WAVE_IO_FILE_COPY_H_
@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "wave/io/file_copy.h"
+#include "wave/test_files.h"
+
+const std::string gResourcePath(TEST_RESOURCES_PATH);
+
+TEST(FileCopy, SameFile) {
+  using namespace wave;
+  auto path = gResourcePath + "/same-file.wav";
+  auto content = TestRamp(100, 0);
+  ASSERT_EQ(WriteTestFile(path, 1, &content), kNoError);
+
+  // converting a file to the directory it is in would overwrite it
+  ASSERT_TRUE(SameFile(path, path));
+  ASSERT_TRUE(SameFile(path, gResourcePath + "/./same-file.wav"));
+  ASSERT_TRUE(SameFile(path, gResourcePath + "/../" +
+                                 gResourcePath.substr(
+                                     gResourcePath.find_last_of('/') + 1) +
+                                 "/same-file.wav"));
+
+  ASSERT_FALSE(SameFile(path, gResourcePath + "/Untitled3.wav"));
+  // outputs that don't exist yet can't be an input
+  ASSERT_FALSE(SameFile(path, gResourcePath + "/missing.wav"));
+  ASSERT_FALSE(SameFile(gResourcePath + "/missing.wav",
+                        gResourcePath + "/missing.wav"));
+}
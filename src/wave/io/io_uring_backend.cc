@@ -0,0 +1,280 @@
+#include "wave/io_backend.h"
+
+#ifdef WAVE_HAVE_IO_URING
+#include "wave/io/io_uring_backend.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace wave {
+
+namespace {
+
+int Setup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int Enter(int ring_fd, unsigned to_submit, unsigned min_complete,
+          unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+unsigned LoadAcquire(unsigned* value) {
+  return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+void StoreRelease(unsigned* value, unsigned new_value) {
+  __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+}
+
+// user data of the entry waking up the reaper on destruction
+const uint64_t kWakeUp = 0;
+
+}  // namespace
+
+IOUringBackend::IOUringBackend()
+    : ring_fd_(-1),
+      sq_ring_(MAP_FAILED),
+      sq_ring_size_(0),
+      cq_ring_(MAP_FAILED),
+      cq_ring_size_(0),
+      sqes_(static_cast<io_uring_sqe*>(MAP_FAILED)),
+      sqes_size_(0),
+      in_flight_(0),
+      stop_(false) {}
+
+IOUringBackend::~IOUringBackend() {
+  if (reaper_.joinable()) {
+    {
+      // let the pending reads complete, then wake the reaper up with a no-op
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return in_flight_ == 0; });
+      stop_ = true;
+      SubmitEntry(IORING_OP_NOP, -1, 0, 0, 0, kWakeUp);
+    }
+    reaper_.join();
+  }
+  // run the pending callbacks
+  callbacks_.reset();
+  if (sqes_ != MAP_FAILED) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != MAP_FAILED) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+bool IOUringBackend::Init(unsigned queue_depth, size_t thread_number) {
+  memset(&params_, 0, sizeof(params_));
+  ring_fd_ = Setup(queue_depth, &params_);
+  if (ring_fd_ < 0) {
+    return false;
+  }
+
+  // map the rings
+  sq_ring_size_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params_.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap && cq_ring_size_ > sq_ring_size_) {
+    sq_ring_size_ = cq_ring_size_;
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    return false;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return false;
+    }
+  }
+  sqes_size_ = params_.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe*>(
+      mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+  if (sqes_ == MAP_FAILED) {
+    return false;
+  }
+
+  auto sq = static_cast<char*>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq + params_.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params_.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned*>(sq + params_.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params_.sq_off.array);
+  auto cq = static_cast<char*>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params_.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params_.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned*>(cq + params_.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params_.cq_off.cqes);
+
+  callbacks_.reset(new ThreadPool(thread_number));
+  reaper_ = std::thread(&IOUringBackend::Reap, this);
+  return true;
+}
+
+int IOUringBackend::Open(const std::string& path) {
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handles_[fd] = Handle{0, false};
+  }
+  return fd;
+}
+
+void IOUringBackend::Close(int handle) {
+  if (handle < 0) {
+    return;
+  }
+  // short reads may still be resubmitted on the descriptor, it is closed
+  // after the last one completes so that its number isn't reused meanwhile
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = handles_.find(handle);
+  if (found == handles_.end()) {
+    return;
+  }
+  found->second.closed = true;
+  Release(handle);
+}
+
+void IOUringBackend::Release(int fd) {
+  auto found = handles_.find(fd);
+  if (found != handles_.end() && found->second.closed &&
+      found->second.reads == 0) {
+    handles_.erase(found);
+    close(fd);
+  }
+}
+
+void IOUringBackend::Read(int handle, uint64_t offset, char* data,
+                          uint64_t size, Callback callback) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this]() { return in_flight_ < params_.sq_entries; });
+  // the descriptor of a closed handle may already be another file's
+  auto found = handles_.find(handle);
+  if (found == handles_.end() || found->second.closed) {
+    lock.unlock();
+    callback(-EBADF);
+    return;
+  }
+  found->second.reads++;
+
+  auto request = new Request();
+  request->fd = handle;
+  request->offset = offset;
+  request->data = data;
+  request->size = size;
+  request->done = 0;
+  request->callback = callback;
+  Submit(request);
+}
+
+void IOUringBackend::Submit(Request* request) {
+  request->iov.iov_base = request->data + request->done;
+  request->iov.iov_len = request->size - request->done;
+  SubmitEntry(IORING_OP_READV, request->fd, request->offset + request->done,
+              reinterpret_cast<uint64_t>(&request->iov), 1,
+              reinterpret_cast<uint64_t>(request));
+}
+
+void IOUringBackend::SubmitEntry(uint8_t opcode, int fd, uint64_t offset,
+                                 uint64_t address, uint32_t length,
+                                 uint64_t user_data) {
+  // only this thread moves the tail, the kernel moves the head
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe* entry = &sqes_[index];
+  memset(entry, 0, sizeof(*entry));
+  entry->opcode = opcode;
+  entry->fd = fd;
+  entry->off = offset;
+  entry->addr = address;
+  entry->len = length;
+  entry->user_data = user_data;
+  sq_array_[index] = index;
+  StoreRelease(sq_tail_, tail + 1);
+  in_flight_++;
+  Enter(ring_fd_, 1, 0, 0);
+}
+
+void IOUringBackend::Reap() {
+  while (true) {
+    unsigned head = *cq_head_;
+    if (head == LoadAcquire(cq_tail_)) {
+      Enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+      continue;
+    }
+    io_uring_cqe completion = cqes_[head & *cq_mask_];
+    StoreRelease(cq_head_, head + 1);
+
+    bool stop = false;
+    Request* finished = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      in_flight_--;
+      if (completion.user_data == kWakeUp) {
+        stop = stop_;
+      } else {
+        auto request = reinterpret_cast<Request*>(completion.user_data);
+        if (completion.res > 0) {
+          request->done += completion.res;
+        }
+        // resubmit the rest of short reads, unless end of file is reached
+        if (completion.res > 0 && request->done < request->size) {
+          Submit(request);
+        } else {
+          finished = request;
+          handles_[request->fd].reads--;
+          Release(request->fd);
+        }
+      }
+    }
+    condition_.notify_all();
+    if (stop) {
+      return;
+    }
+    if (finished != nullptr) {
+      int64_t result = completion.res < 0
+                           ? completion.res
+                           : static_cast<int64_t>(finished->done);
+      callbacks_->Schedule([finished, result]() {
+        finished->callback(result);
+        delete finished;
+      });
+    }
+  }
+}
+
+}  // namespace wave
+#endif  // WAVE_HAVE_IO_URING
+
+namespace wave {
+
+std::unique_ptr<IOBackend> MakeIOUringBackend(unsigned queue_depth,
+                                             size_t thread_number) {
+#ifdef WAVE_HAVE_IO_URING
+  std::unique_ptr<IOUringBackend> backend(new IOUringBackend());
+  if (backend->Init(queue_depth, thread_number)) {
+    return std::unique_ptr<IOBackend>(backend.release());
+  }
+#endif  // WAVE_HAVE_IO_URING
+  return nullptr;
+}
+
+}  // namespace wave
@@ -0,0 +1,96 @@
+#ifndef WAVE_IO_IO_URING_BACKEND_H_
+#define WAVE_IO_IO_URING_BACKEND_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include "wave/io_backend.h"
+#include "wave/thread_pool.h"
+
+namespace wave {
+
+/**
+ * @brief io_uring backend using the raw system calls. Submissions are
+ * serialized by a mutex and a single thread reaps the completions, whose
+ * callbacks run on a thread pool so that decoding is not serialized.
+ */
+class IOUringBackend : public IOBackend {
+ public:
+  IOUringBackend();
+  ~IOUringBackend() override;
+
+  /**
+   * @return false if the kernel refused to create the ring
+   */
+  bool Init(unsigned queue_depth, size_t thread_number);
+
+  int Open(const std::string& path) override;
+  void Close(int handle) override;
+  void Read(int handle, uint64_t offset, char* data, uint64_t size,
+            Callback callback) override;
+
+ private:
+  struct Request {
+    int fd;
+    uint64_t offset;
+    char* data;
+    uint64_t size;
+    uint64_t done;
+    iovec iov;
+    Callback callback;
+  };
+
+  // both have to be called with mutex_ held
+  void Submit(Request* request);
+  // closes the descriptor once it is released and has no read in flight,
+  // to be called with mutex_ held
+  void Release(int fd);
+  void SubmitEntry(uint8_t opcode, int fd, uint64_t offset, uint64_t address,
+                   uint32_t length, uint64_t user_data);
+  void Reap();
+
+  int ring_fd_;
+  io_uring_params params_;
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  io_uring_sqe* sqes_;
+  size_t sqes_size_;
+
+  // submission queue
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned* sq_mask_;
+  unsigned* sq_array_;
+  // completion queue
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned* cq_mask_;
+  io_uring_cqe* cqes_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  // number of requests in the kernel, bounded to the queue size so that the
+  // completion queue never overflows
+  unsigned in_flight_;
+  // reads submitted on each descriptor and not completed yet (resubmitted
+  // short reads included), and whether Close was called on it
+  struct Handle {
+    unsigned reads;
+    bool closed;
+  };
+  std::unordered_map<int, Handle> handles_;
+  bool stop_;
+  std::thread reaper_;
+  std::unique_ptr<ThreadPool> callbacks_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_IO_IO_URING_BACKEND_H_
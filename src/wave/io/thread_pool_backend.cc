@@ -0,0 +1,61 @@
+#include "wave/io/thread_pool_backend.h"
+
+namespace wave {
+
+ThreadPoolBackend::ThreadPoolBackend(size_t thread_number)
+    : pool_(thread_number) {}
+
+int ThreadPoolBackend::Open(const std::string& path) {
+  std::shared_ptr<OpenedFile> file(new OpenedFile());
+  if (file->stream.Open(path, std::ios::in) != kNoError) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  // reuse the slot of a closed file if any
+  for (size_t idx = 0; idx < files_.size(); idx++) {
+    if (files_[idx] == nullptr) {
+      files_[idx] = file;
+      return static_cast<int>(idx);
+    }
+  }
+  files_.push_back(file);
+  return static_cast<int>(files_.size() - 1);
+}
+
+void ThreadPoolBackend::Close(int handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (handle >= 0 && static_cast<size_t>(handle) < files_.size()) {
+    files_[handle].reset();
+  }
+}
+
+void ThreadPoolBackend::Read(int handle, uint64_t offset, char* data,
+                             uint64_t size, Callback callback) {
+  std::shared_ptr<OpenedFile> file;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handle >= 0 && static_cast<size_t>(handle) < files_.size()) {
+      file = files_[handle];
+    }
+  }
+  if (file == nullptr) {
+    callback(-1);
+    return;
+  }
+  pool_.Schedule([file, offset, data, size, callback]() {
+    int64_t result = -1;
+    {
+      std::lock_guard<std::mutex> lock(file->mutex);
+      if (file->stream.Seek(offset)) {
+        result = file->stream.Read(data, size);
+      }
+    }
+    callback(result);
+  });
+}
+
+std::unique_ptr<IOBackend> MakeThreadPoolBackend(size_t thread_number) {
+  return std::unique_ptr<IOBackend>(new ThreadPoolBackend(thread_number));
+}
+
+}  // namespace wave
@@ -0,0 +1,38 @@
+#ifndef WAVE_IO_THREAD_POOL_BACKEND_H_
+#define WAVE_IO_THREAD_POOL_BACKEND_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "wave/io_backend.h"
+#include "wave/stream/file_stream.h"
+#include "wave/thread_pool.h"
+
+namespace wave {
+
+class ThreadPoolBackend : public IOBackend {
+ public:
+  explicit ThreadPoolBackend(size_t thread_number);
+
+  int Open(const std::string& path) override;
+  void Close(int handle) override;
+  void Read(int handle, uint64_t offset, char* data, uint64_t size,
+            Callback callback) override;
+
+ private:
+  // a file is shared with the pending reads so it can be closed at any time
+  struct OpenedFile {
+    std::mutex mutex;
+    FileStream stream;
+  };
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<OpenedFile>> files_;
+  // destroyed first, so that pending reads are done before the files
+  ThreadPool pool_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_IO_THREAD_POOL_BACKEND_H_
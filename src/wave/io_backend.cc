@@ -0,0 +1,18 @@
+#include "wave/io_backend.h"
+
+namespace wave {
+
+std::unique_ptr<IOBackend> MakeIOBackend() {
+  auto backend = MakeIOUringBackend();
+  if (backend == nullptr) {
+    backend = MakeThreadPoolBackend();
+  }
+  return backend;
+}
+
+IOBackend* DefaultIOBackend() {
+  static std::unique_ptr<IOBackend> backend = MakeIOBackend();
+  return backend.get();
+}
+
+}  // namespace wave
@@ -0,0 +1,67 @@
+#ifndef WAVE_WAVE_IO_BACKEND_H_
+#define WAVE_WAVE_IO_BACKEND_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace wave {
+
+/**
+ * @brief Asynchronous positional reads on files, shared by many File objects.
+ * Callbacks are called from a backend thread.
+ */
+class IOBackend {
+ public:
+  // Called with the number of bytes read, or a negative value on error
+  typedef std::function<void(int64_t result)> Callback;
+
+  virtual ~IOBackend() {}
+
+  /**
+   * @brief Open the file at given path for reading.
+   * @return a handle to give to Read, or -1 on error
+   */
+  virtual int Open(const std::string& path) = 0;
+
+  /**
+   * @brief Release the handle. Reads already submitted on it still complete.
+   */
+  virtual void Close(int handle) = 0;
+
+  /**
+   * @brief Submit the read of size bytes at offset into data. data has to stay
+   * valid until callback is called. Reads on a closed or unknown handle fail.
+   */
+  virtual void Read(int handle, uint64_t offset, char* data, uint64_t size,
+                    Callback callback) = 0;
+};
+
+/**
+ * @brief Portable backend running blocking reads on a thread pool
+ */
+std::unique_ptr<IOBackend> MakeThreadPoolBackend(size_t thread_number = 4);
+
+/**
+ * @brief Linux io_uring backend: reads are queued to the kernel and completed
+ * by a single thread, callbacks run on thread_number threads.
+ * @return nullptr when io_uring is not available
+ */
+std::unique_ptr<IOBackend> MakeIOUringBackend(unsigned queue_depth = 256,
+                                             size_t thread_number = 4);
+
+/**
+ * @brief io_uring backend when available, thread pool otherwise
+ */
+std::unique_ptr<IOBackend> MakeIOBackend();
+
+/**
+ * @brief Backend made by MakeIOBackend on first use and shared by the whole
+ * process
+ */
+IOBackend* DefaultIOBackend();
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_IO_BACKEND_H_
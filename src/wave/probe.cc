@@ -0,0 +1,88 @@
+#include "wave/probe.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "wave/header.h"
+#include "wave/io/file_copy.h"
+#include "wave/thread_pool.h"
+
+namespace wave {
+
+namespace {
+
+class Prober {
+ public:
+  Prober() : file_(nullptr) {}
+  ~Prober() {
+    if (file_ != nullptr) {
+      fclose(file_);
+    }
+  }
+
+  Error Open(const std::string& path) {
+    file_ = fopen(path.c_str(), "rb");
+    if (file_ == nullptr) {
+      return kFailedToOpen;
+    }
+    // we read by large blocks ourselves, no need for another buffer
+    setvbuf(file_, nullptr, _IONBF, 0);
+    walker_.Open([this](uint64_t position, char* data, uint64_t size) {
+      return ReadFile(file_, position, data, size);
+    }, FileSize(file_));
+    return kNoError;
+  }
+
+  const ChunkWalker& walker() const { return walker_; }
+
+ private:
+  FILE* file_;
+  ChunkWalker walker_;
+};
+
+}  // namespace
+
+Error Probe(const std::string& path, Metadata* output) {
+  Prober prober;
+  auto error = prober.Open(path);
+  if (error != kNoError) {
+    return error;
+  }
+  FMTHeader fmt;
+  Header data;
+  error = prober.walker().FindFormat(&fmt, &data);
+  if (error != kNoError) {
+    return error;
+  }
+
+  output->audio_format = fmt.audio_format;
+  output->channel_number = fmt.num_channel;
+  output->sample_rate = fmt.sample_rate;
+  output->bits_per_sample = fmt.bits_per_sample;
+  output->frame_number =
+      fmt.byte_per_block == 0 ? 0 : data.content_size() / fmt.byte_per_block;
+  output->duration =
+      fmt.sample_rate == 0
+          ? 0.
+          : static_cast<double>(output->frame_number) / fmt.sample_rate;
+  return kNoError;
+}
+
+std::vector<Error> Probe(const std::vector<std::string>& paths,
+                         std::vector<Metadata>* output,
+                         size_t thread_number) {
+  std::vector<Error> errors(paths.size(), kNoError);
+  output->resize(paths.size());
+  {
+    ThreadPool pool(std::min(thread_number, paths.size()));
+    for (size_t idx = 0; idx < paths.size(); idx++) {
+      pool.Schedule([&paths, &errors, output, idx]() {
+        errors[idx] = Probe(paths[idx], &(*output)[idx]);
+      });
+    }
+    // pool waits for the pending tasks on destruction
+  }
+  return errors;
+}
+
+}  // namespace wave
@@ -0,0 +1,43 @@
+#ifndef WAVE_WAVE_PROBE_H_
+#define WAVE_WAVE_PROBE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+
+namespace wave {
+
+/**
+ * @brief Description of a wave file, as found in its headers
+ */
+struct Metadata {
+  uint16_t audio_format;
+  uint16_t channel_number;
+  uint32_t sample_rate;
+  uint16_t bits_per_sample;
+  uint64_t frame_number;
+  // in seconds
+  double duration;
+};
+
+/**
+ * @brief Read the metadata of the file at given path without opening it as a
+ * File. Only the beginning of the file is read, in a single read when the
+ * fmt and data headers are found there.
+ * @note: unlike File, any audio format is reported.
+ */
+Error Probe(const std::string& path, Metadata* output);
+
+/**
+ * @brief Probe all the given files using thread_number threads.
+ * @return the error of each file, output has the same size as paths
+ */
+std::vector<Error> Probe(const std::vector<std::string>& paths,
+                         std::vector<Metadata>* output,
+                         size_t thread_number = 4);
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_PROBE_H_
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include "wave/file.h"
+#include "wave/probe.h"
+
+const std::string gResourcePath(TEST_RESOURCES_PATH);
+
+TEST(Probe, Read) {
+  using namespace wave;
+
+  for (auto name : {"/Untitled3.wav", "/extra-header.wav"}) {
+    File file;
+    ASSERT_EQ(file.Open(gResourcePath + name, OpenMode::kIn), kNoError);
+
+    Metadata metadata;
+    ASSERT_EQ(Probe(gResourcePath + name, &metadata), kNoError);
+    ASSERT_EQ(metadata.audio_format, 1);
+    ASSERT_EQ(metadata.channel_number, file.channel_number());
+    ASSERT_EQ(metadata.sample_rate, file.sample_rate());
+    ASSERT_EQ(metadata.bits_per_sample, file.bits_per_sample());
+    ASSERT_EQ(metadata.frame_number, file.frame_number());
+    ASSERT_DOUBLE_EQ(metadata.duration,
+                     static_cast<double>(file.frame_number()) /
+                         file.sample_rate());
+  }
+}
+
+TEST(Probe, BigEndian) {
+  using namespace wave;
+  auto path = gResourcePath + "/output.wav";
+  {
+    File file;
+    ASSERT_EQ(file.Open(path, OpenMode::kOut), kNoError);
+    file.set_big_endian(true);
+    file.set_channel_number(2);
+    file.set_sample_rate(48000);
+    ASSERT_EQ(file.Write(std::vector<float>(2000, 0.5f)), kNoError);
+    ASSERT_EQ(file.WriteChunk("note", {'a'}), kNoError);
+  }
+  Metadata metadata;
+  ASSERT_EQ(Probe(path, &metadata), kNoError);
+  ASSERT_EQ(metadata.audio_format, 1);
+  ASSERT_EQ(metadata.channel_number, 2);
+  ASSERT_EQ(metadata.sample_rate, 48000);
+  ASSERT_EQ(metadata.bits_per_sample, 16);
+  ASSERT_EQ(metadata.frame_number, 1000);
+}
+
+TEST(Probe, Errors) {
+  using namespace wave;
+  Metadata metadata;
+  ASSERT_EQ(Probe("incorrect_path", &metadata), kFailedToOpen);
+
+  // format is reported even when File can't read it
+  ASSERT_EQ(Probe(gResourcePath + "/8kulaw.wav", &metadata), kNoError);
+  ASSERT_EQ(metadata.audio_format, 7);
+}
+
+TEST(Probe, Batch) {
+  using namespace wave;
+  std::vector<std::string> paths = {gResourcePath + "/Untitled3.wav",
+                                    "incorrect_path",
+                                    gResourcePath + "/extra-header.wav"};
+  std::vector<Metadata> metadata;
+  auto errors = Probe(paths, &metadata, 2);
+  ASSERT_EQ(errors.size(), paths.size());
+  ASSERT_EQ(metadata.size(), paths.size());
+  ASSERT_EQ(errors[0], kNoError);
+  ASSERT_EQ(errors[1], kFailedToOpen);
+  ASSERT_EQ(errors[2], kNoError);
+
+  Metadata expected;
+  Probe(paths[2], &expected);
+  ASSERT_EQ(metadata[2].frame_number, expected.frame_number);
+  ASSERT_EQ(metadata[0].sample_rate, 44100);
+}
@@ -0,0 +1,270 @@
+#include "wave/stem_reader.h"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <thread>
+
+#include "wave/file.h"
+#include "wave/thread_pool.h"
+
+namespace wave {
+
+namespace {
+
+// frames interleaved for all stems before moving on, so that output frames
+// stay in cache while each stem fills its channels
+const uint64_t kInterleaveFrameNumber = 256;
+
+// Copy the frames of a stem into the frames of output, which are
+// output_channel_number wide. The channel number is a constant for the
+// usual layouts so that the inner loop unrolls.
+template <size_t kChannelNumber>
+void Interleave(const float* source, uint64_t frame_number,
+                size_t output_channel_number, float* destination) {
+  for (uint64_t frame = 0; frame < frame_number; frame++) {
+    for (size_t channel = 0; channel < kChannelNumber; channel++) {
+      destination[channel] = source[channel];
+    }
+    source += kChannelNumber;
+    destination += output_channel_number;
+  }
+}
+
+void Interleave(const float* source, uint64_t frame_number,
+                size_t channel_number, size_t output_channel_number,
+                float* destination) {
+  switch (channel_number) {
+    case 1:
+      return Interleave<1>(source, frame_number, output_channel_number,
+                           destination);
+    case 2:
+      return Interleave<2>(source, frame_number, output_channel_number,
+                           destination);
+  }
+  for (uint64_t frame = 0; frame < frame_number; frame++) {
+    for (size_t channel = 0; channel < channel_number; channel++) {
+      destination[channel] = source[channel];
+    }
+    source += channel_number;
+    destination += output_channel_number;
+  }
+}
+
+}  // namespace
+
+class StemReader::Impl {
+ public:
+  Impl()
+      : position(0),
+        frame_number(0),
+        prefetch_position(0),
+        prefetch_frame_number(0) {}
+  ~Impl() { Close(); }
+
+  void Close() {
+    CancelPrefetch();
+    pool.reset();
+    files.clear();
+    position = 0;
+    frame_number = 0;
+  }
+
+  // Run task for each stem on the pool, without waiting
+  std::vector<std::future<Error>> Schedule(
+      std::function<Error(size_t)> task) {
+    std::vector<std::future<Error>> results;
+    for (size_t stem = 0; stem < files.size(); stem++) {
+      auto promise = std::make_shared<std::promise<Error>>();
+      results.push_back(promise->get_future());
+      pool->Schedule(
+          [promise, task, stem]() { promise->set_value(task(stem)); });
+    }
+    return results;
+  }
+
+  // Wait for all the results, the first error is returned
+  static Error Wait(std::vector<std::future<Error>>* results) {
+    auto error = kNoError;
+    for (auto& result : *results) {
+      auto stem_error = result.get();
+      if (error == kNoError) {
+        error = stem_error;
+      }
+    }
+    results->clear();
+    return error;
+  }
+
+  Error ForEachStem(std::function<Error(size_t)> task) {
+    auto results = Schedule(task);
+    return Wait(&results);
+  }
+
+  // Read the frame_number frames following position in every stem
+  std::vector<std::future<Error>> ScheduleRead(
+      uint64_t frame_number, std::vector<std::vector<float>>* output) {
+    output->resize(files.size());
+    return Schedule([this, frame_number, output](size_t stem) {
+      return files[stem].Read(frame_number, &(*output)[stem]);
+    });
+  }
+
+  // files are left where the prefetch stopped, Read seeks them back when
+  // it doesn't use the prefetched frames
+  void CancelPrefetch() {
+    Wait(&prefetch);
+    prefetch_frame_number = 0;
+  }
+
+  std::vector<File> files;
+  std::unique_ptr<ThreadPool> pool;
+  uint64_t position;
+  uint64_t frame_number;
+
+  // frames read ahead by the previous Read
+  std::vector<std::future<Error>> prefetch;
+  std::vector<std::vector<float>> prefetched;
+  uint64_t prefetch_position;
+  uint64_t prefetch_frame_number;
+
+  // planar frames interleaved by Read
+  std::vector<std::vector<float>> planar;
+};
+
+StemReader::StemReader() : impl_(new Impl()) {}
+
+StemReader::~StemReader() = default;
+
+Error StemReader::Open(const std::vector<std::string>& paths,
+                       size_t thread_number) {
+  Close();
+  if (paths.empty()) {
+    return kInvalidFormat;
+  }
+  impl_->files = std::vector<File>(paths.size());
+  if (thread_number == 0) {
+    thread_number = std::min<size_t>(
+        paths.size(), std::max(std::thread::hardware_concurrency(), 1u));
+  }
+  impl_->pool.reset(new ThreadPool(thread_number));
+  auto error = impl_->ForEachStem([this, &paths](size_t stem) {
+    return impl_->files[stem].Open(paths[stem], kIn);
+  });
+  for (auto& file : impl_->files) {
+    if (error != kNoError) {
+      break;
+    }
+    if (file.sample_rate() != impl_->files.front().sample_rate() ||
+        file.frame_number() != impl_->files.front().frame_number()) {
+      error = kInvalidFormat;
+    }
+  }
+  if (error != kNoError) {
+    Close();
+    return error;
+  }
+  impl_->frame_number = impl_->files.front().frame_number();
+  return kNoError;
+}
+
+void StemReader::Close() { impl_->Close(); }
+
+Error StemReader::Read(uint64_t frame_number,
+                       std::vector<std::vector<float>>* output) {
+  if (impl_->files.empty()) {
+    return kNotOpen;
+  }
+  // same check as File
+  if (impl_->position + frame_number > impl_->frame_number) {
+    return kInvalidFormat;
+  }
+
+  auto error = kNoError;
+  if (!impl_->prefetch.empty() &&
+      impl_->prefetch_position == impl_->position &&
+      impl_->prefetch_frame_number == frame_number) {
+    error = Impl::Wait(&impl_->prefetch);
+    std::swap(*output, impl_->prefetched);
+  } else {
+    impl_->CancelPrefetch();
+    for (auto& file : impl_->files) {
+      if (error == kNoError) {
+        error = file.Seek(impl_->position);
+      }
+    }
+    if (error == kNoError) {
+      auto results = impl_->ScheduleRead(frame_number, output);
+      error = Impl::Wait(&results);
+    }
+  }
+  if (error != kNoError) {
+    return error;
+  }
+  impl_->position += frame_number;
+
+  // read the next block while the caller processes this one
+  if (frame_number > 0 &&
+      impl_->position + frame_number <= impl_->frame_number) {
+    impl_->prefetch_position = impl_->position;
+    impl_->prefetch_frame_number = frame_number;
+    impl_->prefetch = impl_->ScheduleRead(frame_number, &impl_->prefetched);
+  }
+  return kNoError;
+}
+
+Error StemReader::Read(uint64_t frame_number, std::vector<float>* output) {
+  auto error = Read(frame_number, &impl_->planar);
+  if (error != kNoError) {
+    return error;
+  }
+  // offset of the channels of each stem in output frames
+  std::vector<size_t> offsets(stem_number() + 1, 0);
+  for (size_t stem = 0; stem < stem_number(); stem++) {
+    offsets[stem + 1] = offsets[stem] + channel_number(stem);
+  }
+  auto output_channel_number = offsets.back();
+  output->resize(frame_number * output_channel_number);
+  // on the calling thread, the pool is busy with the prefetch
+  for (uint64_t frame = 0; frame < frame_number;
+       frame += kInterleaveFrameNumber) {
+    auto block_frame_number =
+        std::min(kInterleaveFrameNumber, frame_number - frame);
+    auto destination = output->data() + frame * output_channel_number;
+    for (size_t stem = 0; stem < stem_number(); stem++) {
+      auto stem_channel_number = channel_number(stem);
+      Interleave(impl_->planar[stem].data() + frame * stem_channel_number,
+                 block_frame_number, stem_channel_number,
+                 output_channel_number, destination + offsets[stem]);
+    }
+  }
+  return kNoError;
+}
+
+Error StemReader::Seek(uint64_t frame_index) {
+  if (impl_->files.empty()) {
+    return kNotOpen;
+  }
+  if (frame_index > impl_->frame_number) {
+    return kInvalidSeek;
+  }
+  // files are moved by the next Read, unless it uses the prefetched frames
+  impl_->position = frame_index;
+  return kNoError;
+}
+
+uint64_t StemReader::Tell() const { return impl_->position; }
+
+size_t StemReader::stem_number() const { return impl_->files.size(); }
+
+uint16_t StemReader::channel_number(size_t stem) const {
+  return impl_->files[stem].channel_number();
+}
+
+uint32_t StemReader::sample_rate() const {
+  return impl_->files.empty() ? 0 : impl_->files.front().sample_rate();
+}
+
+uint64_t StemReader::frame_number() const { return impl_->frame_number; }
+
+}  // namespace wave
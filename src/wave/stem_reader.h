@@ -0,0 +1,63 @@
+#ifndef WAVE_WAVE_STEM_READER_H_
+#define WAVE_WAVE_STEM_READER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+
+namespace wave {
+
+/**
+ * @brief Read the stems of a song, one file each, together and frame
+ * aligned. Stems are decoded in parallel, and the block following each Read
+ * is prefetched so that successive reads of the same size don't wait.
+ */
+class StemReader {
+ public:
+  StemReader();
+  ~StemReader();
+
+  /**
+   * @brief Open every stem. thread_number threads decode them, one per stem
+   * up to the number of cores when 0.
+   * @note: stems must share their sample rate and frame number or
+   * kInvalidFormat is returned. Their channel numbers may differ.
+   */
+  Error Open(const std::vector<std::string>& paths, size_t thread_number = 0);
+  void Close();
+
+  /**
+   * @brief Read frame_number frames of every stem. output has a vector of
+   * interleaved frames for each stem.
+   */
+  Error Read(uint64_t frame_number, std::vector<std::vector<float>>* output);
+
+  /**
+   * @brief Read frame_number frames of every stem into a single buffer whose
+   * frames hold the channels of the first stem, then of the second one...
+   */
+  Error Read(uint64_t frame_number, std::vector<float>* output);
+
+  /**
+   * @brief Move all the stems to the given frame
+   */
+  Error Seek(uint64_t frame_index);
+  uint64_t Tell() const;
+
+  size_t stem_number() const;
+  // channels of the given stem
+  uint16_t channel_number(size_t stem) const;
+  uint32_t sample_rate() const;
+  uint64_t frame_number() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_STEM_READER_H_
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "wave/stem_reader.h"
+#include "wave/test_files.h"
+
+const std::string gResourcePath(TEST_RESOURCES_PATH);
+
+TEST(StemReader, Read) {
+  using namespace wave;
+  std::vector<uint16_t> channels = {2, 1, 3, 1};
+  const uint64_t kFrameNumber = 100000;
+  std::vector<std::string> paths;
+  std::vector<std::vector<float>> contents;
+  for (size_t stem = 0; stem < channels.size(); stem++) {
+    paths.push_back(gResourcePath + "/output-stem-" + std::to_string(stem) +
+                    ".wav");
+    contents.push_back(TestRamp(kFrameNumber * channels[stem], stem));
+    ASSERT_EQ(WriteTestFile(paths.back(), channels[stem], &contents.back()),
+              kNoError);
+  }
+
+  StemReader reader;
+  ASSERT_EQ(reader.Open(paths), kNoError);
+  ASSERT_EQ(reader.stem_number(), paths.size());
+  ASSERT_EQ(reader.frame_number(), kFrameNumber);
+  ASSERT_EQ(reader.sample_rate(), 44100);
+  ASSERT_EQ(reader.channel_number(1), 1);
+
+  // blocks of the same size use the prefetched frames
+  const uint64_t kBlockSize = 4096;
+  std::vector<std::vector<float>> block;
+  for (uint64_t frame = 0; frame + kBlockSize <= kFrameNumber;
+       frame += kBlockSize) {
+    ASSERT_EQ(reader.Tell(), frame);
+    ASSERT_EQ(reader.Read(kBlockSize, &block), kNoError);
+    ASSERT_EQ(block.size(), paths.size());
+    for (size_t stem = 0; stem < paths.size(); stem++) {
+      auto begin = contents[stem].begin() + frame * channels[stem];
+      ASSERT_TRUE(std::equal(block[stem].begin(), block[stem].end(), begin));
+      ASSERT_EQ(block[stem].size(), kBlockSize * channels[stem]);
+    }
+  }
+
+  // seek away from the prefetched frames, then read all stems in one buffer
+  ASSERT_EQ(reader.Seek(1000), kNoError);
+  std::vector<float> interleaved;
+  ASSERT_EQ(reader.Read(50, &interleaved), kNoError);
+  ASSERT_EQ(interleaved.size(), 50 * 7);
+  for (uint64_t frame = 0; frame < 50; frame++) {
+    size_t channel = 0;
+    for (size_t stem = 0; stem < paths.size(); stem++) {
+      for (size_t idx = 0; idx < channels[stem]; idx++, channel++) {
+        ASSERT_EQ(interleaved[frame * 7 + channel],
+                  contents[stem][(1000 + frame) * channels[stem] + idx]);
+      }
+    }
+  }
+  ASSERT_EQ(reader.Tell(), 1050);
+
+  ASSERT_EQ(reader.Read(kFrameNumber, &block), kInvalidFormat);
+  ASSERT_EQ(reader.Seek(kFrameNumber + 1), kInvalidSeek);
+  ASSERT_EQ(reader.Seek(kFrameNumber - 10), kNoError);
+  ASSERT_EQ(reader.Read(10, &block), kNoError);
+}
+
+TEST(StemReader, Errors) {
+  using namespace wave;
+  StemReader reader;
+  std::vector<float> content;
+  ASSERT_EQ(reader.Read(10, &content), kNotOpen);
+  ASSERT_EQ(reader.Open({}), kInvalidFormat);
+  ASSERT_EQ(reader.Open({gResourcePath + "/Untitled3.wav", "incorrect_path"}),
+            kFailedToOpen);
+
+  // stems have to be frame aligned
+  auto path = gResourcePath + "/output-stem.wav";
+  content = TestRamp(1000 * 2, 0);
+  ASSERT_EQ(WriteTestFile(path, 2, &content), kNoError);
+  ASSERT_EQ(reader.Open({path, gResourcePath + "/Untitled3.wav"}),
+            kInvalidFormat);
+  ASSERT_EQ(reader.stem_number(), 0);
+  ASSERT_EQ(reader.Open({path, path}, 1), kNoError);
+}
@@ -0,0 +1,92 @@
+#ifndef WAVE_WAVE_STREAM_H_
+#define WAVE_WAVE_STREAM_H_
+
+#include <cstdint>
+
+namespace wave {
+
+/**
+ * @brief Byte level access to the storage of a wave file (a file on disk,
+ * a memory region...). Header parsing and sample decoding only go through
+ * this interface.
+ */
+class Stream {
+ public:
+  virtual ~Stream() {}
+
+  virtual bool is_open() const = 0;
+  virtual void Close() = 0;
+
+  /**
+   * @brief Read up to size bytes at the current position.
+   * @return the number of bytes actually read
+   */
+  virtual uint64_t Read(char* data, uint64_t size) = 0;
+
+  /**
+   * @brief Give direct access to size bytes at the current position and move
+   * past them, for storages that allow it (e.g. memory).
+   * @return nullptr if the bytes have to be copied with Read
+   */
+  virtual const char* ReadView(uint64_t size) { return nullptr; }
+
+  /**
+   * @brief Whether ReadAt is supported. Storages that don't support it are
+   * read with Seek and Read.
+   */
+  virtual bool can_read_at() const { return false; }
+
+  /**
+   * @brief Read up to size bytes at the given position, without moving the
+   * current position. Several threads can read at once.
+   * @return the number of bytes actually read
+   */
+  virtual uint64_t ReadAt(uint64_t position, char* data, uint64_t size) {
+    return 0;
+  }
+
+  /**
+   * @brief Write size bytes at the current position.
+   * @return the number of bytes actually written
+   */
+  virtual uint64_t Write(const char* data, uint64_t size) = 0;
+
+  /**
+   * @brief Whether WriteAt is supported. Storages that don't support it are
+   * written with Seek and Write.
+   */
+  virtual bool can_write_at() const { return false; }
+
+  /**
+   * @brief Write size bytes at the given position, without moving the current
+   * position. Disjoint ranges can be written from several threads at once.
+   * @return the number of bytes actually written
+   */
+  virtual uint64_t WriteAt(uint64_t position, const char* data,
+                           uint64_t size) {
+    return 0;
+  }
+
+  /**
+   * @brief Move to the given byte position.
+   * @return false if the position could not be reached
+   */
+  virtual bool Seek(uint64_t position) = 0;
+  virtual uint64_t Tell() = 0;
+
+  /**
+   * @brief Total size of the stream in bytes.
+   */
+  virtual uint64_t Size() = 0;
+
+  virtual bool Flush() { return true; }
+
+  /**
+   * @brief Reserve storage for size bytes up front, when supported.
+   */
+  virtual bool Reserve(uint64_t size) { return false; }
+};
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_STREAM_H_
@@ -0,0 +1,183 @@
+#include "wave/stream/direct_file_stream.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wave {
+
+namespace {
+// alignment of file offsets, sizes and memory required by O_DIRECT. A page
+// is a multiple of every usual logical block size
+const uint64_t kAlignment = 4096;
+// size of the blocks written to the file
+const uint64_t kBlockSize = 1 << 20;
+
+bool WriteAll(int fd, const char* data, uint64_t size, uint64_t offset) {
+  while (size > 0) {
+    auto written = pwrite(fd, data, size, offset);
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+}  // namespace
+
+DirectFileStream::DirectFileStream()
+    : fd_(-1),
+      buffer_(nullptr),
+      buffer_offset_(0),
+      position_(0),
+      size_(0),
+      failed_(false) {}
+
+DirectFileStream::~DirectFileStream() {
+  Close();
+  free(buffer_);
+}
+
+Error DirectFileStream::Open(const std::string& path) {
+  Close();
+  if (buffer_ == nullptr) {
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, kAlignment, kBlockSize) != 0) {
+      return kFailedToOpen;
+    }
+    buffer_ = static_cast<char*>(buffer);
+  }
+  memset(buffer_, 0, kBlockSize);
+  buffer_offset_ = 0;
+  position_ = 0;
+  size_ = 0;
+  failed_ = false;
+  patches_.clear();
+
+  auto flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+  fd_ = open(path.c_str(), flags | O_DIRECT, 0644);
+  // some file systems (e.g. tmpfs) refuse O_DIRECT, keep the large aligned
+  // writes anyway
+  if (fd_ < 0) {
+    fd_ = open(path.c_str(), flags, 0644);
+  }
+#else
+  fd_ = open(path.c_str(), flags, 0644);
+#endif  // O_DIRECT
+  if (fd_ < 0) {
+    return kFailedToOpen;
+  }
+#ifdef F_NOCACHE
+  fcntl(fd_, F_NOCACHE, 1);
+#endif  // F_NOCACHE
+  return kNoError;
+}
+
+bool DirectFileStream::is_open() const { return fd_ >= 0; }
+
+bool DirectFileStream::failed() const { return failed_; }
+
+void DirectFileStream::Close() {
+  if (fd_ < 0) {
+    return;
+  }
+  if (!failed_ && size_ > buffer_offset_) {
+    // the tail is written as a padded aligned block, then cut to size
+    auto tail = size_ - buffer_offset_;
+    auto padded_tail = (tail + kAlignment - 1) / kAlignment * kAlignment;
+    failed_ = !WriteAll(fd_, buffer_, padded_tail, buffer_offset_);
+  }
+  // truncating also releases the space reserved beyond the end
+  if (!failed_) {
+    failed_ = ftruncate(fd_, size_) != 0;
+  }
+  if (!failed_ && !patches_.empty()) {
+    // patches are not aligned, go back to regular writes
+#ifdef O_DIRECT
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+#endif  // O_DIRECT
+    for (auto& patch : patches_) {
+      if (!WriteAll(fd_, patch.second.data(), patch.second.size(),
+                    patch.first)) {
+        failed_ = true;
+        break;
+      }
+    }
+  }
+  if (close(fd_) != 0) {
+    failed_ = true;
+  }
+  fd_ = -1;
+}
+
+uint64_t DirectFileStream::Read(char* data, uint64_t size) { return 0; }
+
+uint64_t DirectFileStream::Write(const char* data, uint64_t size) {
+  if (fd_ < 0 || failed_) {
+    return 0;
+  }
+  uint64_t written = 0;
+  // part of the write landing before the buffer
+  if (position_ < buffer_offset_) {
+    auto count = std::min(size, buffer_offset_ - position_);
+    auto& patch = patches_[position_];
+    if (patch.size() < count) {
+      patch.resize(count);
+    }
+    memcpy(patch.data(), data, count);
+    written += count;
+    position_ += count;
+  }
+  while (written < size) {
+    if (position_ >= buffer_offset_ + kBlockSize) {
+      if (!FlushBlock()) {
+        return written;
+      }
+      continue;
+    }
+    auto buffer_position = position_ - buffer_offset_;
+    auto count = std::min(size - written, kBlockSize - buffer_position);
+    memcpy(buffer_ + buffer_position, data + written, count);
+    written += count;
+    position_ += count;
+    size_ = std::max(size_, position_);
+  }
+  return written;
+}
+
+bool DirectFileStream::FlushBlock() {
+  if (!WriteAll(fd_, buffer_, kBlockSize, buffer_offset_)) {
+    failed_ = true;
+    return false;
+  }
+  memset(buffer_, 0, kBlockSize);
+  buffer_offset_ += kBlockSize;
+  return true;
+}
+
+bool DirectFileStream::Seek(uint64_t position) {
+  position_ = position;
+  return true;
+}
+
+uint64_t DirectFileStream::Tell() { return position_; }
+
+uint64_t DirectFileStream::Size() { return size_; }
+
+bool DirectFileStream::Reserve(uint64_t size) {
+#ifdef __linux__
+  // keep the size so that the file never shows garbage past written data
+  return fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, size) == 0;
+#else
+  return false;
+#endif  // __linux__
+}
+
+}  // namespace wave
@@ -0,0 +1,59 @@
+#ifndef WAVE_STREAM_DIRECT_FILE_STREAM_H_
+#define WAVE_STREAM_DIRECT_FILE_STREAM_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+#include "wave/stream.h"
+
+namespace wave {
+
+/**
+ * @brief Write only stream bypassing the page cache (O_DIRECT on Linux,
+ * F_NOCACHE on macOS).
+ * Data goes through an aligned buffer and is written by large aligned blocks.
+ * Writes before the buffered block (e.g. header updates) are kept aside and
+ * applied on Close, after the unaligned tail has been written.
+ */
+class DirectFileStream : public Stream {
+ public:
+  DirectFileStream();
+  ~DirectFileStream() override;
+
+  Error Open(const std::string& path);
+
+  /**
+   * @brief Whether a write failed since Open, including the ones done on
+   * Close. Writes stop at the first failure.
+   */
+  bool failed() const;
+
+  bool is_open() const override;
+  void Close() override;
+  uint64_t Read(char* data, uint64_t size) override;
+  uint64_t Write(const char* data, uint64_t size) override;
+  bool Seek(uint64_t position) override;
+  uint64_t Tell() override;
+  uint64_t Size() override;
+  bool Reserve(uint64_t size) override;
+
+ private:
+  // write the whole buffer to the file and move it to the next block
+  bool FlushBlock();
+
+  int fd_;
+  char* buffer_;
+  // file offset of the first byte of the buffer, always aligned
+  uint64_t buffer_offset_;
+  uint64_t position_;
+  uint64_t size_;
+  bool failed_;
+  // writes that landed before the buffer, by file offset
+  std::map<uint64_t, std::vector<char>> patches_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_STREAM_DIRECT_FILE_STREAM_H_
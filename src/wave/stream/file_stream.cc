@@ -0,0 +1,165 @@
+#include "wave/stream/file_stream.h"
+
+#ifdef WAVE_HAVE_POSITIONAL_IO
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // WAVE_HAVE_POSITIONAL_IO
+
+namespace wave {
+
+namespace {
+// size of the buffer handed to the file
+const size_t kBufferSize = 1 << 16;
+}  // namespace
+
+FileStream::FileStream() : mode_(std::ios::in), fd_(-1), reserved_(false) {}
+
+FileStream::~FileStream() { Close(); }
+
+Error FileStream::Open(const std::string& path, std::ios::openmode mode) {
+  Close();
+  // the buffer has to be given before the file gets opened
+  if (buffer_.empty()) {
+    buffer_.resize(kBufferSize);
+  }
+  file_.pubsetbuf(buffer_.data(), buffer_.size());
+  if (file_.open(path.c_str(), mode | std::ios::binary) == nullptr) {
+    return Error::kFailedToOpen;
+  }
+  path_ = path;
+  mode_ = mode;
+  return Error::kNoError;
+}
+
+bool FileStream::is_open() const { return file_.is_open(); }
+
+void FileStream::Close() {
+  if (file_.is_open()) {
+    file_.close();
+  }
+#ifdef WAVE_HAVE_POSITIONAL_IO
+  int fd = fd_.exchange(-1);
+  if (fd >= 0) {
+    // truncating to the current size releases the space reserved beyond it
+    struct stat info;
+    if (reserved_ && fstat(fd, &info) == 0) {
+      reserved_ = ftruncate(fd, info.st_size) != 0;
+    }
+    close(fd);
+  }
+  reserved_ = false;
+#endif  // WAVE_HAVE_POSITIONAL_IO
+}
+
+uint64_t FileStream::Read(char* data, uint64_t size) {
+  return file_.sgetn(data, size);
+}
+
+uint64_t FileStream::Write(const char* data, uint64_t size) {
+  return file_.sputn(data, size);
+}
+
+bool FileStream::Seek(uint64_t position) {
+  return file_.pubseekpos(position) != std::streampos(std::streamoff(-1));
+}
+
+uint64_t FileStream::Tell() {
+  return file_.pubseekoff(0, std::ios::cur);
+}
+
+uint64_t FileStream::Size() {
+  auto position = file_.pubseekoff(0, std::ios::cur);
+  auto size = file_.pubseekoff(0, std::ios::end);
+  file_.pubseekpos(position);
+  return size;
+}
+
+bool FileStream::Flush() { return file_.pubsync() == 0; }
+
+bool FileStream::can_read_at() const {
+#ifdef WAVE_HAVE_POSITIONAL_IO
+  return is_open() && (mode_ & std::ios::in) && !(mode_ & std::ios::out);
+#else
+  return false;
+#endif  // WAVE_HAVE_POSITIONAL_IO
+}
+
+uint64_t FileStream::ReadAt(uint64_t position, char* data, uint64_t size) {
+  uint64_t read = 0;
+#ifdef WAVE_HAVE_POSITIONAL_IO
+  auto fd = OpenDescriptor();
+  if (fd < 0) {
+    return 0;
+  }
+  while (read < size) {
+    auto count = pread(fd, data + read, size - read,
+                       static_cast<off_t>(position + read));
+    if (count <= 0) {
+      break;
+    }
+    read += count;
+  }
+#endif  // WAVE_HAVE_POSITIONAL_IO
+  return read;
+}
+
+bool FileStream::can_write_at() const {
+#ifdef WAVE_HAVE_POSITIONAL_IO
+  return is_open() && (mode_ & std::ios::out);
+#else
+  return false;
+#endif  // WAVE_HAVE_POSITIONAL_IO
+}
+
+int FileStream::OpenDescriptor() {
+#ifdef WAVE_HAVE_POSITIONAL_IO
+  auto fd = fd_.load();
+  if (fd >= 0 || (!can_write_at() && !can_read_at())) {
+    return fd;
+  }
+  std::lock_guard<std::mutex> lock(fd_mutex_);
+  fd = fd_.load();
+  if (fd < 0) {
+    fd = open(path_.c_str(), can_write_at() ? O_WRONLY : O_RDONLY);
+    fd_.store(fd);
+  }
+  return fd;
+#else
+  return -1;
+#endif  // WAVE_HAVE_POSITIONAL_IO
+}
+
+uint64_t FileStream::WriteAt(uint64_t position, const char* data,
+                             uint64_t size) {
+  uint64_t written = 0;
+#ifdef WAVE_HAVE_POSITIONAL_IO
+  auto fd = OpenDescriptor();
+  if (fd < 0) {
+    return 0;
+  }
+  while (written < size) {
+    auto count = pwrite(fd, data + written, size - written,
+                        static_cast<off_t>(position + written));
+    if (count <= 0) {
+      break;
+    }
+    written += count;
+  }
+#endif  // WAVE_HAVE_POSITIONAL_IO
+  return written;
+}
+
+bool FileStream::Reserve(uint64_t size) {
+#if defined(WAVE_HAVE_POSITIONAL_IO) && defined(__linux__)
+  auto fd = OpenDescriptor();
+  // keep the size so that the file never shows garbage past written data
+  reserved_ = fd >= 0 && fallocate(fd, FALLOC_FL_KEEP_SIZE, 0,
+                                    static_cast<off_t>(size)) == 0;
+  return reserved_;
+#else
+  return false;
+#endif  // WAVE_HAVE_POSITIONAL_IO && __linux__
+}
+
+}  // namespace wave
@@ -0,0 +1,60 @@
+#ifndef WAVE_STREAM_FILE_STREAM_H_
+#define WAVE_STREAM_FILE_STREAM_H_
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+#include "wave/stream.h"
+
+namespace wave {
+
+/**
+ * @brief Stream on a file from disk. The buffer is kept when the stream is
+ * closed so it can be reopened without any allocation.
+ * Where supported (unix), ReadAt, WriteAt and Reserve go through a second
+ * descriptor on the file, opened on first use. ReadAt is only supported when
+ * the file is opened for reading only, writes buffered by the stream would
+ * not be seen.
+ */
+class FileStream : public Stream {
+ public:
+  FileStream();
+  ~FileStream();
+
+  Error Open(const std::string& path, std::ios::openmode mode);
+
+  bool is_open() const override;
+  void Close() override;
+  uint64_t Read(char* data, uint64_t size) override;
+  uint64_t Write(const char* data, uint64_t size) override;
+  bool Seek(uint64_t position) override;
+  uint64_t Tell() override;
+  uint64_t Size() override;
+  bool Flush() override;
+  bool can_read_at() const override;
+  uint64_t ReadAt(uint64_t position, char* data, uint64_t size) override;
+  bool can_write_at() const override;
+  uint64_t WriteAt(uint64_t position, const char* data,
+                   uint64_t size) override;
+  bool Reserve(uint64_t size) override;
+
+ private:
+  // descriptor used by ReadAt, WriteAt and Reserve, or -1
+  int OpenDescriptor();
+
+  std::filebuf file_;
+  std::vector<char> buffer_;
+  std::string path_;
+  std::ios::openmode mode_;
+  std::atomic<int> fd_;
+  std::mutex fd_mutex_;
+  bool reserved_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_STREAM_FILE_STREAM_H_
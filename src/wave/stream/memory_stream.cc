@@ -0,0 +1,64 @@
+#include "wave/stream/memory_stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wave {
+
+MemoryStream::MemoryStream() : data_(nullptr), size_(0), position_(0) {}
+
+void MemoryStream::Open(const char* data, uint64_t size) {
+  data_ = data;
+  size_ = size;
+  position_ = 0;
+}
+
+bool MemoryStream::is_open() const { return data_ != nullptr; }
+
+void MemoryStream::Close() { Open(nullptr, 0); }
+
+uint64_t MemoryStream::Read(char* data, uint64_t size) {
+  if (position_ >= size_) {
+    return 0;
+  }
+  auto count = std::min(size, size_ - position_);
+  memcpy(data, data_ + position_, count);
+  position_ += count;
+  return count;
+}
+
+const char* MemoryStream::ReadView(uint64_t size) {
+  if (position_ + size > size_) {
+    return nullptr;
+  }
+  auto view = data_ + position_;
+  position_ += size;
+  return view;
+}
+
+bool MemoryStream::can_read_at() const { return is_open(); }
+
+uint64_t MemoryStream::ReadAt(uint64_t position, char* data, uint64_t size) {
+  if (position >= size_) {
+    return 0;
+  }
+  auto count = std::min(size, size_ - position);
+  memcpy(data, data_ + position, count);
+  return count;
+}
+
+uint64_t MemoryStream::Write(const char* data, uint64_t size) { return 0; }
+
+bool MemoryStream::Seek(uint64_t position) {
+  if (position > size_) {
+    return false;
+  }
+  position_ = position;
+  return true;
+}
+
+uint64_t MemoryStream::Tell() { return position_; }
+
+uint64_t MemoryStream::Size() { return size_; }
+
+}  // namespace wave
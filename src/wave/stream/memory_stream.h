@@ -0,0 +1,36 @@
+#ifndef WAVE_STREAM_MEMORY_STREAM_H_
+#define WAVE_STREAM_MEMORY_STREAM_H_
+
+#include "wave/stream.h"
+
+namespace wave {
+
+/**
+ * @brief Read only stream on a memory region. Data is not copied: the region
+ * has to outlive the stream.
+ */
+class MemoryStream : public Stream {
+ public:
+  MemoryStream();
+  void Open(const char* data, uint64_t size);
+
+  bool is_open() const override;
+  void Close() override;
+  uint64_t Read(char* data, uint64_t size) override;
+  const char* ReadView(uint64_t size) override;
+  bool can_read_at() const override;
+  uint64_t ReadAt(uint64_t position, char* data, uint64_t size) override;
+  uint64_t Write(const char* data, uint64_t size) override;
+  bool Seek(uint64_t position) override;
+  uint64_t Tell() override;
+  uint64_t Size() override;
+
+ private:
+  const char* data_;
+  uint64_t size_;
+  uint64_t position_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_STREAM_MEMORY_STREAM_H_
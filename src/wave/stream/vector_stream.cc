@@ -0,0 +1,57 @@
+#include "wave/stream/vector_stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wave {
+
+VectorStream::VectorStream() : buffer_(nullptr), position_(0) {}
+
+void VectorStream::Open(std::vector<char>* buffer) {
+  buffer_ = buffer;
+  position_ = 0;
+}
+
+bool VectorStream::is_open() const { return buffer_ != nullptr; }
+
+void VectorStream::Close() { Open(nullptr); }
+
+uint64_t VectorStream::Read(char* data, uint64_t size) {
+  if (position_ >= buffer_->size()) {
+    return 0;
+  }
+  auto count = std::min<uint64_t>(size, buffer_->size() - position_);
+  memcpy(data, buffer_->data() + position_, count);
+  position_ += count;
+  return count;
+}
+
+const char* VectorStream::ReadView(uint64_t size) {
+  if (position_ + size > buffer_->size()) {
+    return nullptr;
+  }
+  auto view = buffer_->data() + position_;
+  position_ += size;
+  return view;
+}
+
+uint64_t VectorStream::Write(const char* data, uint64_t size) {
+  if (position_ + size > buffer_->size()) {
+    buffer_->resize(position_ + size);
+  }
+  memcpy(buffer_->data() + position_, data, size);
+  position_ += size;
+  return size;
+}
+
+bool VectorStream::Seek(uint64_t position) {
+  // like a file, seeking past the end is allowed and grows on next write
+  position_ = position;
+  return true;
+}
+
+uint64_t VectorStream::Tell() { return position_; }
+
+uint64_t VectorStream::Size() { return buffer_->size(); }
+
+}  // namespace wave
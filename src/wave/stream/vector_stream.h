@@ -0,0 +1,35 @@
+#ifndef WAVE_STREAM_VECTOR_STREAM_H_
+#define WAVE_STREAM_VECTOR_STREAM_H_
+
+#include <vector>
+
+#include "wave/stream.h"
+
+namespace wave {
+
+/**
+ * @brief Stream on a growable buffer owned by the caller. Writing past the
+ * end of the buffer resizes it.
+ */
+class VectorStream : public Stream {
+ public:
+  VectorStream();
+  void Open(std::vector<char>* buffer);
+
+  bool is_open() const override;
+  void Close() override;
+  uint64_t Read(char* data, uint64_t size) override;
+  const char* ReadView(uint64_t size) override;
+  uint64_t Write(const char* data, uint64_t size) override;
+  bool Seek(uint64_t position) override;
+  uint64_t Tell() override;
+  uint64_t Size() override;
+
+ private:
+  std::vector<char>* buffer_;
+  uint64_t position_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_STREAM_VECTOR_STREAM_H_
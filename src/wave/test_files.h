@@ -0,0 +1,50 @@
+#ifndef WAVE_WAVE_TEST_FILES_H_
+#define WAVE_WAVE_TEST_FILES_H_
+
+#include <string>
+#include <vector>
+
+#include "wave/file.h"
+
+namespace wave {
+
+/**
+ * @brief Samples of a ramp, different for each seed, to fill test files.
+ */
+inline std::vector<float> TestRamp(size_t sample_number, size_t seed) {
+  std::vector<float> samples(sample_number);
+  for (size_t idx = 0; idx < sample_number; idx++) {
+    samples[idx] = static_cast<float>((idx * (seed + 1)) % 1000) / 1000.f;
+  }
+  return samples;
+}
+
+/**
+ * @brief Write content to a new file at path, then replace it with what is
+ * read back, which is what tests compare to.
+ */
+inline Error WriteTestFile(const std::string& path, uint16_t channel_number,
+                           std::vector<float>* content,
+                           uint16_t bits_per_sample = 16,
+                           bool big_endian = false) {
+  File file;
+  auto error = file.Open(path, kOut);
+  if (error != kNoError) {
+    return error;
+  }
+  file.set_channel_number(channel_number);
+  file.set_bits_per_sample(bits_per_sample);
+  file.set_big_endian(big_endian);
+  error = file.Write(*content);
+  if (error == kNoError) {
+    error = file.Close();
+  }
+  if (error == kNoError) {
+    error = file.Open(path, kIn);
+  }
+  return error == kNoError ? file.Read(content) : error;
+}
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_TEST_FILES_H_
@@ -0,0 +1,38 @@
+#ifndef WAVE_WAVE_THREAD_POOL_H_
+#define WAVE_WAVE_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wave {
+
+/**
+ * @brief Fixed number of threads running scheduled tasks. Tasks start in
+ * the order they were scheduled, and may run concurrently with more than
+ * one thread. Pending tasks are run before the pool gets destroyed.
+ */
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t thread_number);
+  ~ThreadPool();
+
+  void Schedule(std::function<void()> task);
+  size_t thread_number() const;
+
+ private:
+  void Run();
+
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stop_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_THREAD_POOL_H_
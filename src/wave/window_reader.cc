@@ -0,0 +1,186 @@
+#include "wave/window_reader.h"
+
+#include <cstring>
+
+#include "wave/file.h"
+
+namespace wave {
+
+class WindowReader::Impl {
+ public:
+  Impl() : window_size(0), hop_size(0), window_index(0), begin(0), end(0) {}
+
+  // Make the window_size frames following begin hold window window_index,
+  // reading only the frames the previous window doesn't have
+  Error Advance() {
+    auto channel_number = file.channel_number();
+    if (end == 0 || hop_size >= window_size) {
+      // nothing to keep from the previous window
+      end = 0;
+      auto error = file.Seek(window_index * hop_size);
+      if (error == kNoError) {
+        error = file.Read(window_size, buffer.data());
+      }
+      if (error != kNoError) {
+        return error;
+      }
+      begin = 0;
+      end = window_size;
+      return kNoError;
+    }
+
+    begin += hop_size;
+    if (begin + window_size > capacity()) {
+      // move the frames kept to the front of the buffer. This happens once
+      // every window_size / hop_size windows and copies less than hop_size
+      // frames per window on average.
+      std::memmove(buffer.data(), buffer.data() + begin * channel_number,
+                   (end - begin) * channel_number * sizeof(float));
+      end -= begin;
+      begin = 0;
+    }
+    auto error = file.Read(begin + window_size - end,
+                           buffer.data() + end * channel_number);
+    if (error != kNoError) {
+      // frames in buffer don't follow each other anymore
+      end = 0;
+      return error;
+    }
+    end = begin + window_size;
+    return kNoError;
+  }
+
+  // frames the buffer can hold
+  uint64_t capacity() const {
+    return hop_size < window_size ? 2 * window_size : window_size;
+  }
+
+  File file;
+  uint64_t window_size;
+  uint64_t hop_size;
+  std::vector<float> window_function;
+  // index of the window given by the next call to Next
+  uint64_t window_index;
+
+  // decoded frames, the current window starts at frame begin. Frames up to
+  // end follow each other in file, end is 0 when buffer has to be refilled.
+  std::vector<float> buffer;
+  uint64_t begin;
+  uint64_t end;
+
+  // window multiplied by window_function
+  std::vector<float> windowed;
+};
+
+WindowReader::WindowReader() : impl_(new Impl()) {}
+
+WindowReader::~WindowReader() = default;
+
+Error WindowReader::Open(const std::string& path, uint64_t window_size,
+                         uint64_t hop_size) {
+  Close();
+  if (window_size == 0 || hop_size == 0) {
+    return kInvalidFormat;
+  }
+  auto error = impl_->file.Open(path, kIn);
+  if (error != kNoError) {
+    return error;
+  }
+  impl_->window_size = window_size;
+  impl_->hop_size = hop_size;
+  impl_->buffer.resize(impl_->capacity() * channel_number());
+  return kNoError;
+}
+
+void WindowReader::Close() {
+  impl_->file.Reset();
+  impl_->window_size = 0;
+  impl_->hop_size = 0;
+  impl_->window_function.clear();
+  impl_->window_index = 0;
+  impl_->buffer.clear();
+  impl_->begin = 0;
+  impl_->end = 0;
+}
+
+Error WindowReader::set_window_function(
+    const std::vector<float>& window_function) {
+  if (!window_function.empty() &&
+      window_function.size() != impl_->window_size) {
+    return kInvalidFormat;
+  }
+  impl_->window_function = window_function;
+  return kNoError;
+}
+
+Error WindowReader::Next(const float** window) {
+  if (impl_->window_size == 0) {
+    return kNotOpen;
+  }
+  if (impl_->window_index >= window_number()) {
+    return kInvalidFormat;
+  }
+  auto error = impl_->Advance();
+  if (error != kNoError) {
+    return error;
+  }
+  impl_->window_index++;
+
+  auto channel_number = this->channel_number();
+  const float* frames = impl_->buffer.data() + impl_->begin * channel_number;
+  if (impl_->window_function.empty()) {
+    *window = frames;
+    return kNoError;
+  }
+  // buffered frames belong to the next windows as well, they are left as is
+  impl_->windowed.resize(impl_->window_size * channel_number);
+  auto windowed = impl_->windowed.data();
+  for (uint64_t frame = 0; frame < impl_->window_size; frame++) {
+    auto coefficient = impl_->window_function[frame];
+    for (uint16_t channel = 0; channel < channel_number; channel++) {
+      windowed[channel] = frames[channel] * coefficient;
+    }
+    frames += channel_number;
+    windowed += channel_number;
+  }
+  *window = impl_->windowed.data();
+  return kNoError;
+}
+
+Error WindowReader::Seek(uint64_t window_index) {
+  if (impl_->window_size == 0) {
+    return kNotOpen;
+  }
+  if (window_index > window_number()) {
+    return kInvalidSeek;
+  }
+  if (window_index != impl_->window_index) {
+    impl_->window_index = window_index;
+    impl_->end = 0;
+  }
+  return kNoError;
+}
+
+uint64_t WindowReader::Tell() const { return impl_->window_index; }
+
+uint64_t WindowReader::window_number() const {
+  auto frame_number = impl_->file.frame_number();
+  if (impl_->window_size == 0 || frame_number < impl_->window_size) {
+    return 0;
+  }
+  return (frame_number - impl_->window_size) / impl_->hop_size + 1;
+}
+
+uint64_t WindowReader::window_size() const { return impl_->window_size; }
+
+uint64_t WindowReader::hop_size() const { return impl_->hop_size; }
+
+uint16_t WindowReader::channel_number() const {
+  return impl_->file.channel_number();
+}
+
+uint32_t WindowReader::sample_rate() const {
+  return impl_->file.sample_rate();
+}
+
+}  // namespace wave
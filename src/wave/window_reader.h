@@ -0,0 +1,70 @@
+#ifndef WAVE_WAVE_WINDOW_READER_H_
+#define WAVE_WAVE_WINDOW_READER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wave/error.h"
+
+namespace wave {
+
+/**
+ * @brief Read a file as overlapping windows of window_size frames, one every
+ * hop_size frames, as STFT and other frame based analyses do. Frames shared
+ * by successive windows are kept in a buffer of at most twice the window size,
+ * so that each sample is decoded only once.
+ */
+class WindowReader {
+ public:
+  WindowReader();
+  ~WindowReader();
+
+  /**
+   * @brief Open the file to read. The first window starts at its first frame.
+   * @note: window_size and hop_size must not be 0 or kInvalidFormat is
+   * returned. Frames between windows are skipped when hop_size is larger
+   * than window_size.
+   */
+  Error Open(const std::string& path, uint64_t window_size, uint64_t hop_size);
+  void Close();
+
+  /**
+   * @brief Multiply the windows given by Next by window_function, which has
+   * a coefficient for each frame of the window. Empty to disable it.
+   * @note: kInvalidFormat is returned if its size is not the window size.
+   */
+  Error set_window_function(const std::vector<float>& window_function);
+
+  /**
+   * @brief Move to the next window. window points to its window_size
+   * interleaved frames, which stay valid until the next call to Next, Seek,
+   * Open or Close.
+   * @note: kInvalidFormat is returned past the last window, like File::Read
+   * past the end of file.
+   */
+  Error Next(const float** window);
+
+  /**
+   * @brief Move to the given window, Next gives it next.
+   */
+  Error Seek(uint64_t window_index);
+  // index of the window given by the next call to Next
+  uint64_t Tell() const;
+
+  // number of complete windows in file
+  uint64_t window_number() const;
+  uint64_t window_size() const;
+  uint64_t hop_size() const;
+  uint16_t channel_number() const;
+  uint32_t sample_rate() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace wave
+
+#endif  // WAVE_WAVE_WINDOW_READER_H_
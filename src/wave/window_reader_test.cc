@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "wave/file.h"
+#include "wave/window_reader.h"
+
+const std::string gResourcePath(TEST_RESOURCES_PATH);
+
+TEST(WindowReader, Next) {
+  using namespace wave;
+  auto path = gResourcePath + "/Untitled3.wav";
+  File file;
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  std::vector<float> content;
+  ASSERT_EQ(file.Read(&content), kNoError);
+  auto channel_number = file.channel_number();
+  auto frame_number = file.frame_number();
+
+  // overlapping, contiguous and disjoint windows
+  std::vector<std::pair<uint64_t, uint64_t>> sizes = {
+      {2048, 512}, {1000, 999}, {1024, 1024}, {512, 3000}, {1, 1}};
+  for (const auto& size : sizes) {
+    auto window_size = size.first;
+    auto hop_size = size.second;
+    WindowReader reader;
+    ASSERT_EQ(reader.Open(path, window_size, hop_size), kNoError);
+    ASSERT_EQ(reader.channel_number(), channel_number);
+    ASSERT_EQ(reader.sample_rate(), 44100);
+    ASSERT_EQ(reader.window_number(),
+              (frame_number - window_size) / hop_size + 1);
+
+    const float* window = nullptr;
+    for (uint64_t index = 0; index < reader.window_number(); index++) {
+      ASSERT_EQ(reader.Tell(), index);
+      ASSERT_EQ(reader.Next(&window), kNoError);
+      auto expected = content.data() + index * hop_size * channel_number;
+      for (uint64_t idx = 0; idx < window_size * channel_number; idx++) {
+        ASSERT_EQ(window[idx], expected[idx]);
+      }
+    }
+    ASSERT_EQ(reader.Next(&window), kInvalidFormat);
+  }
+}
+
+TEST(WindowReader, WindowFunction) {
+  using namespace wave;
+  auto path = gResourcePath + "/Untitled3.wav";
+  File file;
+  ASSERT_EQ(file.Open(path, OpenMode::kIn), kNoError);
+  std::vector<float> content;
+  ASSERT_EQ(file.Read(&content), kNoError);
+  auto channel_number = file.channel_number();
+
+  const uint64_t kWindowSize = 2048;
+  const uint64_t kHopSize = 512;
+  std::vector<float> hann(kWindowSize);
+  for (uint64_t frame = 0; frame < kWindowSize; frame++) {
+    hann[frame] = 0.5f - 0.5f * std::cos(2.f * static_cast<float>(M_PI) *
+                                         frame / kWindowSize);
+  }
+
+  WindowReader reader;
+  ASSERT_EQ(reader.Open(path, kWindowSize, kHopSize), kNoError);
+  ASSERT_EQ(reader.set_window_function(std::vector<float>(10)),
+            kInvalidFormat);
+  ASSERT_EQ(reader.set_window_function(hann), kNoError);
+
+  // windows are multiplied without changing the frames shared with the next
+  // ones, in order and after seeking
+  std::vector<uint64_t> indices = {0, 1, 2, 3, 4, 5, 6, 7, 8, 100, 101, 3};
+  const float* window = nullptr;
+  for (auto index : indices) {
+    ASSERT_EQ(reader.Seek(index), kNoError);
+    ASSERT_EQ(reader.Next(&window), kNoError);
+    auto expected = content.data() + index * kHopSize * channel_number;
+    for (uint64_t frame = 0; frame < kWindowSize; frame++) {
+      for (uint16_t channel = 0; channel < channel_number; channel++) {
+        auto idx = frame * channel_number + channel;
+        ASSERT_EQ(window[idx], expected[idx] * hann[frame]);
+      }
+    }
+  }
+}
+
+TEST(WindowReader, Errors) {
+  using namespace wave;
+  WindowReader reader;
+  const float* window = nullptr;
+  ASSERT_EQ(reader.Next(&window), kNotOpen);
+  ASSERT_EQ(reader.Seek(0), kNotOpen);
+  auto path = gResourcePath + "/Untitled3.wav";
+  ASSERT_EQ(reader.Open(path, 0, 512), kInvalidFormat);
+  ASSERT_EQ(reader.Open(path, 2048, 0), kInvalidFormat);
+  ASSERT_EQ(reader.Open(gResourcePath + "/missing.wav", 2048, 512),
+            kFailedToOpen);
+  ASSERT_EQ(reader.Open(path, 2048, 512), kNoError);
+  ASSERT_EQ(reader.Seek(reader.window_number() + 1), kInvalidSeek);
+  ASSERT_EQ(reader.Seek(reader.window_number()), kNoError);
+  ASSERT_EQ(reader.Next(&window), kInvalidFormat);
+}